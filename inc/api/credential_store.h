@@ -0,0 +1,44 @@
+#ifndef _LOFTILI_API_CREDENTIAL_STORE_H
+#define _LOFTILI_API_CREDENTIAL_STORE_H
+
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "config.h"
+#include "api.h"
+#include "spdlog/spdlog.h"
+
+namespace loftili {
+
+namespace api {
+
+// remembers the token and device id the api gave us so a restart can skip
+// registration. the file is replaced atomically (written aside, synced, then
+// renamed over the old one) so a crash mid-write never leaves half of it, and
+// it records the serial it belongs to so a different device ignores it.
+class CredentialStore {
+  public:
+    CredentialStore() : m_path(LOFTILI_STATE_PATH) { };
+    CredentialStore(std::string path) : m_path(path) { };
+    CredentialStore(const CredentialStore&) = default;
+    CredentialStore& operator=(const CredentialStore&) = default;
+    ~CredentialStore() = default;
+
+    bool Load(const std::string&, loftili::api::DeviceCredentials&);
+    bool Save(const std::string&, const loftili::api::DeviceCredentials&);
+    void Clear();
+
+  private:
+    std::string m_path;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef _LOFTILI_API_DEVICE_HEADERS_H
+#define _LOFTILI_API_DEVICE_HEADERS_H
+
+#include <mutex>
+#include <string>
+#include "api.h"
+#include "net/http_request.h"
+
+namespace loftili {
+
+namespace api {
+
+// the token and serial headers sent with every api request, rendered once and
+// re-rendered only when the credentials change (e.g. after registering).
+loftili::net::HttpHeaderBlock DeviceHeaders();
+
+}
+
+}
+
+#endif
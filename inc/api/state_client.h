@@ -7,6 +7,8 @@
 #include "rapidjson/reader.h"
 #include "lib/json_parser.h"
 #include "net/http_request.h"
+#include "api/device_headers.h"
+#include "api/state_publisher.h"
 #include "net/http_response.h"
 #include "net/http_client.h"
 
@@ -21,9 +23,6 @@ class StateClient {
     StateClient& operator=(const StateClient&) = default;
     ~StateClient() = default;
     void Update(std::string, int);
-
-  private:
-    std::string StateUrl();
 };
 
 }
@@ -0,0 +1,55 @@
+#ifndef _LOFTILI_API_STATE_PUBLISHER_H
+#define _LOFTILI_API_STATE_PUBLISHER_H
+
+#define LOFTILI_STATE_RETRY_BASE_MS 1000
+#define LOFTILI_STATE_RETRY_CAP_MS 60000
+#define LOFTILI_STATE_TOTAL_MS 15000
+
+#include <map>
+#include <memory>
+#include <string>
+#include <sstream>
+#include "config.h"
+#include "api.h"
+#include "spdlog/spdlog.h"
+#include "lib/backoff.h"
+#include "lib/metrics.h"
+#include "net/http_request.h"
+#include "net/reactor.h"
+#include "net/http_transfer.h"
+#include "api/device_headers.h"
+
+namespace loftili {
+
+namespace api {
+
+// sends device state to the api from the reactor. updates made while a put is
+// in flight (or waiting to be retried) are merged by key, the latest value
+// winning, and go out together in the next put; only one is ever in flight.
+class StatePublisher {
+  public:
+    StatePublisher();
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+    ~StatePublisher() = default;
+
+    void Update(const std::string&, int);
+
+  private:
+    void Flush();
+    int Published(std::shared_ptr<loftili::net::HttpResponse>);
+    void Retry(const std::map<std::string, int>&);
+    std::string StateUrl();
+
+    std::map<std::string, int> m_pending;
+    loftili::lib::Backoff m_backoff;
+    bool m_sending;
+};
+
+extern loftili::api::StatePublisher publisher;
+
+}
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef _LOFTILI_AUDIO_ALSA_SINK_H
+#define _LOFTILI_AUDIO_ALSA_SINK_H
+
+#include "config.h"
+
+#if HAVE_ALSA
+
+#define LOFTILI_ALSA_DEVICE "default"
+#define LOFTILI_ALSA_PERIOD_FRAMES 1024
+#define LOFTILI_ALSA_BUFFER_FRAMES 4096
+#define LOFTILI_ALSA_WAIT_MS 20
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <errno.h>
+#include <algorithm>
+#include <alsa/asoundlib.h>
+#include "spdlog/spdlog.h"
+#include "audio/audio_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+// plays through alsa's mmap interface: Begin hands out the next free stretch
+// of the device's own ring buffer, so samples go from the pcm ring into the
+// hardware buffer with a single copy and no write call in between. underruns
+// are recovered from in place and counted.
+class AlsaSink : public loftili::audio::AudioSink {
+  public:
+    explicit AlsaSink(const loftili::audio::SinkConfiguration&);
+    ~AlsaSink();
+    bool Open(const loftili::audio::AudioFormat&);
+    void Close();
+    const char* Name() { return "alsa"; }
+    unsigned char* Begin(size_t&);
+    bool Commit(size_t);
+    void Idle();
+    void Drain();
+
+  protected:
+    bool Play(const unsigned char*, size_t) { return false; }
+
+  private:
+    bool Configure(const loftili::audio::AudioFormat&);
+    bool Recover(int);
+    void Measure();
+
+    std::string m_name;
+    snd_pcm_t* m_pcm;
+    snd_pcm_uframes_t m_period;
+    snd_pcm_uframes_t m_buffer;
+    snd_pcm_uframes_t m_offset;
+    size_t m_frame;
+    unsigned int m_rate;
+};
+
+}
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _LOFTILI_AUDIO_AO_SINK_H
+#define _LOFTILI_AUDIO_AO_SINK_H
+
+#include <ao/ao.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "audio/audio_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+// libao's default driver; it keeps its buffering to itself, so there is no
+// delay to report.
+class AoSink : public loftili::audio::AudioSink {
+  public:
+    AoSink() : m_device(NULL) { };
+    ~AoSink();
+    bool Open(const loftili::audio::AudioFormat&);
+    void Close();
+    const char* Name() { return "libao"; }
+
+  protected:
+    bool Play(const unsigned char*, size_t);
+
+  private:
+    ao_device* m_device;
+};
+
+}
+
+}
+
+#endif
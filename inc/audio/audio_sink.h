@@ -0,0 +1,78 @@
+#ifndef _LOFTILI_AUDIO_AUDIO_SINK_H
+#define _LOFTILI_AUDIO_AUDIO_SINK_H
+
+#define LOFTILI_SINK_CHUNK_BYTES 8192
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "spdlog/spdlog.h"
+
+namespace loftili {
+
+namespace audio {
+
+struct AudioFormat {
+  int bits;
+  int rate;
+  int channels;
+};
+
+// which sink plays audio, chosen on the command line. device is the alsa pcm
+// or the file written to; period and buffer are in frames and rate is what
+// everything is converted to, each 0 for the default.
+struct SinkConfiguration {
+  std::string backend;
+  std::string device;
+  int period;
+  int buffer;
+  int rate;
+};
+
+extern loftili::audio::SinkConfiguration sink_configuration;
+
+// somewhere decoded samples end up. everything but Open and Close runs on
+// the output thread, so implementations must not allocate or lock there.
+// samples are written in two steps: Begin hands out room for up to the bytes
+// asked for (shrinking the count to what it gave), and Commit plays however
+// much of it was filled. a sink that can expose its device buffer does so,
+// and the output thread copies from the ring straight into it; the others
+// hand out a buffer of their own and play it on commit. Idle is called when
+// the ring has run dry, so a sink holding back samples can let them go, and
+// Drain once it has run dry at the end of playback, returning only once
+// everything committed has been heard. Close drops whatever is left.
+class AudioSink {
+  public:
+    AudioSink() : m_chunk(LOFTILI_SINK_CHUNK_BYTES), m_delay(0), m_xruns(0) { };
+    AudioSink(const AudioSink&) = delete;
+    AudioSink& operator=(const AudioSink&) = delete;
+    virtual ~AudioSink() = default;
+
+    virtual bool Open(const loftili::audio::AudioFormat&) = 0;
+    virtual void Close() = 0;
+    virtual const char* Name() = 0;
+    virtual unsigned char* Begin(size_t&);
+    virtual bool Commit(size_t);
+    virtual void Idle() { };
+    virtual void Drain() { };
+
+    // milliseconds of audio written but not yet heard, as last measured
+    long Delay() { return m_delay; }
+    long Xruns() { return m_xruns; }
+
+    static AudioSink* Create(const loftili::audio::SinkConfiguration&);
+    static bool Known(const std::string&);
+
+  protected:
+    virtual bool Play(const unsigned char*, size_t) = 0;
+    std::vector<unsigned char> m_chunk;
+    std::atomic<long> m_delay;
+    std::atomic<long> m_xruns;
+};
+
+}
+
+}
+
+#endif
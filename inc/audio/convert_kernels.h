@@ -0,0 +1,68 @@
+#ifndef _LOFTILI_AUDIO_CONVERT_KERNELS_H
+#define _LOFTILI_AUDIO_CONVERT_KERNELS_H
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "config.h"
+
+#if defined(__SSE2__)
+#define LOFTILI_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LOFTILI_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace loftili {
+
+namespace audio {
+
+// one xorshift generator per vector lane, so dither noise is made as wide as
+// the samples it is added to. lanes must start out non-zero.
+struct DitherState {
+  uint32_t lanes[8];
+};
+
+// the inner loops of sample conversion, one table per instruction set. every
+// table does the same arithmetic and reads and writes unaligned memory; the
+// vector ones hand whatever is left past their last full vector to the
+// scalar code. counts are in samples, except mono_to_stereo which takes
+// frames, and fir whose count is the length of the coefficient run.
+struct ConvertKernels {
+  const char* name;
+  void (*s16_to_float)(const int16_t*, float*, size_t);
+  void (*s32_to_float)(const int32_t*, float*, size_t);
+  void (*mono_to_stereo)(const float*, float*, size_t);
+  // rounds to the nearest step after adding triangular noise one step either
+  // way, or plainly when given no dither state
+  void (*float_to_s16)(const float*, int16_t*, size_t, loftili::audio::DitherState*);
+  // dot product of interleaved stereo frames against coefficients laid out
+  // the same way, giving one left and one right sample. the count is a
+  // multiple of eight.
+  void (*fir)(const float*, const float*, size_t, float*);
+
+  // the fastest table this machine can run, decided on first use
+  static const loftili::audio::ConvertKernels& Best();
+  static const loftili::audio::ConvertKernels& Scalar();
+  static std::vector<const loftili::audio::ConvertKernels*> Available();
+};
+
+#if LOFTILI_KERNELS_X86
+extern const loftili::audio::ConvertKernels sse2_kernels;
+extern const loftili::audio::ConvertKernels avx2_kernels;
+#endif
+
+#if LOFTILI_KERNELS_NEON
+extern const loftili::audio::ConvertKernels neon_kernels;
+#endif
+
+}
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _LOFTILI_AUDIO_CONVERTER_H
+#define _LOFTILI_AUDIO_CONVERTER_H
+
+#define LOFTILI_DEVICE_RATE 44100
+#define LOFTILI_DEVICE_CHANNELS 2
+#define LOFTILI_DEVICE_BITS 16
+#define LOFTILI_BENCHMARK_SAMPLES 65536
+#define LOFTILI_BENCHMARK_MS 200
+
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <mpg123.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "audio/audio_sink.h"
+#include "audio/resampler.h"
+#include "audio/convert_kernels.h"
+
+namespace loftili {
+
+namespace audio {
+
+// turns whatever the decoder produces (signed 16 or 32 bit or float samples,
+// mono or stereo, at any rate) into the one format the device is opened in,
+// so the device never has to be reopened between tracks. decoder output goes
+// to float, mono is spread over both channels, the rate is changed if it
+// differs, and the result is dithered back down to 16 bits. 16 bit stereo at
+// the device rate is passed through untouched.
+class Converter {
+  public:
+    Converter();
+    Converter(const Converter&) = delete;
+    Converter& operator=(const Converter&) = delete;
+
+    bool Configure(long, int, int);
+    size_t Convert(const unsigned char*, size_t, const unsigned char**);
+    size_t Flush(const unsigned char**);
+    void Reset();
+    const loftili::audio::AudioFormat& Format() { return m_format; }
+
+    // times every kernel this machine can run against the scalar ones and
+    // prints the results, for -k on the command line
+    static int Benchmark();
+
+  private:
+    size_t Finish(const float*, size_t, const unsigned char**);
+
+    const loftili::audio::ConvertKernels& m_kernels;
+    loftili::audio::AudioFormat m_format;
+    loftili::audio::Resampler m_resampler;
+    loftili::audio::DitherState m_dither;
+    long m_rate;
+    int m_channels;
+    int m_encoding;
+    bool m_resampling;
+    std::vector<float> m_float;
+    std::vector<float> m_stereo;
+    std::vector<float> m_resampled;
+    std::vector<int16_t> m_out;
+};
+
+}
+
+}
+
+#endif
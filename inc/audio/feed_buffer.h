@@ -0,0 +1,62 @@
+#ifndef _LOFTILI_AUDIO_FEED_BUFFER_H
+#define _LOFTILI_AUDIO_FEED_BUFFER_H
+
+#include <mutex>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include "config.h"
+
+namespace loftili {
+
+namespace audio {
+
+// hands encoded bytes from the download to the decoder. the writer appends
+// whatever the network gives it and finishes once the response is done; the
+// reader blocks until there is something to decode. the writer never waits:
+// once LOFTILI_FEED_BUFFER_BYTES are waiting in memory the rest goes to a
+// spill file, read back in order once the decoder gets to it, so a track
+// fetched well ahead of time still comes off the network at full speed.
+// a reader that gives up abandons the buffer, which fails the writer's next
+// write and with it the download.
+class FeedBuffer {
+  public:
+    FeedBuffer() : m_offset(0), m_spill(NULL), m_spilled(0), m_unspilled(0), m_finished(false), m_ok(false), m_abandoned(false) { };
+    FeedBuffer(const FeedBuffer&) = delete;
+    FeedBuffer& operator=(const FeedBuffer&) = delete;
+    ~FeedBuffer();
+
+    bool Write(const char*, size_t);
+    void Finish(bool);
+    void Abandon();
+
+    size_t Wait(size_t);
+    size_t Read(unsigned char*, size_t);
+    size_t Buffered();
+    bool Finished();
+    bool Ok();
+
+  private:
+    bool Spill(const char*, size_t);
+    size_t Unspill(unsigned char*, size_t);
+    size_t Waiting() { return m_data.size() - m_offset + (m_spilled - m_unspilled); }
+
+    std::vector<unsigned char> m_data;
+    size_t m_offset;
+    FILE* m_spill;
+    size_t m_spilled;
+    size_t m_unspilled;
+    bool m_finished;
+    bool m_ok;
+    bool m_abandoned;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+};
+
+}
+
+}
+
+#endif
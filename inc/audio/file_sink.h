@@ -0,0 +1,41 @@
+#ifndef _LOFTILI_AUDIO_FILE_SINK_H
+#define _LOFTILI_AUDIO_FILE_SINK_H
+
+#define LOFTILI_FILE_SINK_PATH "loftili.pcm"
+
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "audio/audio_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+// writes raw interleaved samples to a file as fast as they come, for
+// checking output and timing decode on machines without sound hardware.
+class FileSink : public loftili::audio::AudioSink {
+  public:
+    explicit FileSink(const std::string& path) : m_path(path), m_handle(-1) { };
+    ~FileSink();
+    bool Open(const loftili::audio::AudioFormat&);
+    void Close();
+    const char* Name() { return "file"; }
+
+  protected:
+    bool Play(const unsigned char*, size_t);
+
+  private:
+    std::string m_path;
+    int m_handle;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _LOFTILI_AUDIO_NULL_SINK_H
+#define _LOFTILI_AUDIO_NULL_SINK_H
+
+#include <chrono>
+#include <thread>
+#include "audio/audio_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+// throws samples away at the rate a real device would play them, so the
+// whole pipeline, underruns and all, behaves as it would with hardware.
+class NullSink : public loftili::audio::AudioSink {
+  public:
+    NullSink() : m_rate(0) { };
+    bool Open(const loftili::audio::AudioFormat&);
+    void Close() { };
+    const char* Name() { return "null"; }
+
+  protected:
+    bool Play(const unsigned char*, size_t);
+
+  private:
+    long m_rate;
+    std::chrono::steady_clock::time_point m_clock;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _LOFTILI_AUDIO_OUTPUT_H
+#define _LOFTILI_AUDIO_OUTPUT_H
+
+#define LOFTILI_OUTPUT_RING_BYTES 1048576
+#define LOFTILI_OUTPUT_CHUNK_BYTES 8192
+#define LOFTILI_OUTPUT_POLL_MS 2
+#define LOFTILI_OUTPUT_TARGET_MIN_MS 100
+#define LOFTILI_OUTPUT_TARGET_START_MS 250
+#define LOFTILI_OUTPUT_WINDOW_MS 10000
+#define LOFTILI_OUTPUT_NO_BOUNDARY UINT64_MAX
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <stdint.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+#include "audio/pcm_ring.h"
+#include "audio/audio_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+// the audio sink and the thread that feeds it. the decoder writes samples
+// into a ring and the output thread moves them from it into the sink, so a slow decode or
+// a stalled download is absorbed by whatever is queued instead of being
+// heard. the output thread only ever touches the ring, a few atomics and the
+// sink: it never allocates, logs or locks.
+//
+// playback starts, and resumes after running dry, once the ring holds the
+// target fill. the decoder side watches how low the ring gets between its
+// writes; the target grows whenever the output runs dry or comes close to it
+// and shrinks back slowly over windows where it never did.
+//
+// Mark notes where in the stream one track ends and the next begins. the
+// output thread times how long the device went without samples between the
+// two, less whatever it still had queued, and that is reported as the gap.
+class Output {
+  public:
+    Output();
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+    ~Output();
+
+    bool Open(const loftili::audio::AudioFormat&);
+    bool Write(const unsigned char*, size_t);
+    void Drain();
+    void Mark();
+    void Close();
+    bool Opened() { return m_open; }
+    const loftili::audio::AudioFormat& Format() { return m_format; }
+
+  private:
+    void Run();
+    void Crossed(size_t);
+    void Adapt(size_t);
+    void Retarget(long);
+    long Milliseconds(size_t);
+    size_t Bytes(long);
+
+    loftili::audio::PcmRing m_ring;
+    std::unique_ptr<loftili::audio::AudioSink> m_sink;
+    std::thread m_thread;
+    bool m_open;
+    loftili::audio::AudioFormat m_format;
+    size_t m_frame;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_draining;
+    std::atomic<bool> m_drained;
+    std::atomic<bool> m_idle;
+    std::atomic<size_t> m_target;
+    std::atomic<long> m_underruns;
+    std::atomic<uint64_t> m_boundary;
+    std::atomic<long> m_gap;
+
+    // output thread only; carried over when the thread is restarted
+    uint64_t m_played;
+    bool m_dry;
+    long m_dry_delay;
+    std::chrono::steady_clock::time_point m_dry_since;
+
+    // decoder side only
+    long m_target_ms;
+    long m_seen_underruns;
+    uint64_t m_written;
+    size_t m_low;
+    std::chrono::steady_clock::time_point m_window;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _LOFTILI_AUDIO_PCM_RING_H
+#define _LOFTILI_AUDIO_PCM_RING_H
+
+#define LOFTILI_RING_CACHE_LINE 64
+
+#include <atomic>
+#include <vector>
+#include <string.h>
+#include <algorithm>
+
+namespace loftili {
+
+namespace audio {
+
+// a fixed size ring of decoded samples with exactly one writer and one
+// reader. each side owns one index and only reads the other's, so neither
+// ever waits on a lock; positions run freely and are masked into the buffer,
+// which is why the capacity is always a power of two.
+class PcmRing {
+  public:
+    explicit PcmRing(size_t);
+    PcmRing(const PcmRing&) = delete;
+    PcmRing& operator=(const PcmRing&) = delete;
+    ~PcmRing() = default;
+
+    size_t Write(const unsigned char*, size_t);
+    size_t Read(unsigned char*, size_t);
+    size_t Available() const;
+    size_t Capacity() const { return m_data.size(); }
+    void Reset();
+
+  private:
+    std::vector<unsigned char> m_data;
+    size_t m_mask;
+
+    // kept a cache line apart so the two sides don't keep stealing it
+    std::atomic<size_t> m_head;
+    char m_padding[LOFTILI_RING_CACHE_LINE];
+    std::atomic<size_t> m_tail;
+};
+
+}
+
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <unistd.h>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <mpg123.h>
 #include "config.h"
 #include "spdlog/spdlog.h"
@@ -18,12 +20,16 @@ class Engine;
 
 namespace audio {
 
+// commands arrive on the reactor thread, which must never wait on playback:
+// playback fetches through the reactor, so waiting there would wait forever.
+// start, stop and skip only leave word for one long-lived playback thread and
+// wake it; the thread is joined once, when playback is destroyed.
 class Playback {
   public:
-    Playback() = default;
-    ~Playback() = default;
-    Playback(const Playback&) = default;
-    Playback& operator=(const Playback&) = default;
+    Playback() : m_state(PLAYBACK_STATE_STOPPED), m_wanted(false), m_restart(false), m_closing(false) { };
+    ~Playback();
+    Playback(const Playback&) = delete;
+    Playback& operator=(const Playback&) = delete;
 
     void Skip();
     void Start();
@@ -37,12 +43,19 @@ class Playback {
 
   private:
     void Run();
+    void Play();
+    bool Continuing();
+    void Wake();
     std::thread m_thread;
     loftili::audio::Queue m_queue;
     loftili::audio::Player m_player;
     loftili::api::StateClient m_stateclient;
     PLAYBACK_STATE m_state;
     std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_wanted;
+    bool m_restart;
+    bool m_closing;
 
 };
 
@@ -3,31 +3,45 @@
 
 #include <iostream>
 #include <memory>
+#include <chrono>
+#include <vector>
+#include <functional>
 #include <unistd.h>
-#include <fstream>
 #include <mpg123.h>
 #include <ao/ao.h>
 #include "api.h"
 #include "config.h"
 #include "spdlog/spdlog.h"
-#include "net/url.h"
-#include "net/http_client.h"
-#include "net/http_request.h"
+#include "lib/metrics.h"
+#include "audio/track.h"
+#include "audio/track_cache.h"
+#include "audio/output.h"
+#include "audio/converter.h"
 
 namespace loftili {
 
 namespace audio {
 
+#define LOFTILI_PLAYER_ADVANCE_PENDING -2
+
+// asked once the playing track has fully downloaded, and again on every
+// block decoded after that until it has an answer; gives the id of the track
+// that follows it, to fetch ahead of time, -1 if none, or
+// LOFTILI_PLAYER_ADVANCE_PENDING while that is still being looked up. it must
+// never block, as it runs between blocks of audio.
+typedef std::function<int()> PlayerAdvance;
+
 class Player {
   public:
-    Player() = default;
-    Player(const Player&) = default;
-    Player& operator=(const Player&) = default;
-    ~Player() = default;
+    Player() : m_state(PLAYER_STATE_STOPPED), m_running(false), m_continuing(false) { };
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+    ~Player();
 
-    bool Play();
+    bool Play(int, loftili::audio::PlayerAdvance advance = loftili::audio::PlayerAdvance());
     int State() { return m_state; };
     void Stop();
+    void Release();
     operator bool();
 
     enum PLAYER_STATE {
@@ -37,12 +51,22 @@ class Player {
     };
 
   private:
-    std::string StreamUrl();
+    std::string StreamUrl(int);
+    bool Configure(loftili::audio::Track&);
+    loftili::audio::Track* Fetch(int, bool);
+    void Finish();
+    mpg123_handle* Handle();
+    void Reclaim(std::unique_ptr<loftili::audio::Track>&);
     void Startup();
     void Shutdown();
-    bool Exists(std::string);
     PLAYER_STATE m_state;
-    std::unique_ptr<std::string> m_stream;
+    std::unique_ptr<loftili::audio::Track> m_next;
+    std::vector<mpg123_handle*> m_handles;
+    loftili::audio::TrackCache m_cache;
+    loftili::audio::Converter m_converter;
+    loftili::audio::Output m_output;
+    bool m_running;
+    bool m_continuing;
 };
 
 }
@@ -3,14 +3,21 @@
 
 #include <iostream>
 #include <queue> 
+#include <atomic>
+#include <memory>
 #include "config.h"
 #include "spdlog/spdlog.h"
 #include "api.h"
-#include "rapidjson/document.h"
+#include "rapidjson/reader.h"
+#include "lib/json_binding.h"
+#include "lib/metrics.h"
 #include "api/registration.h"
 #include "audio/player.h"
+#include "net/reactor.h"
 #include "net/http_client.h"
+#include "net/http_transfer.h"
 #include "net/http_request.h"
+#include "api/device_headers.h"
 #include "api/state_client.h"
 
 namespace loftili {
@@ -19,8 +26,7 @@ namespace audio {
 
 class Queue {
   public:
-    friend class Parser;
-    Queue() = default;
+    Queue() : m_head(-1), m_next(-1), m_stale(true) { };
     Queue(const Queue&) = default;
     Queue& operator=(const Queue&) = default;
     ~Queue() = default;
@@ -29,8 +35,34 @@ class Queue {
     void Pop();
 
   private:
+    // the reactor's answer to which track follows the one playing, read by
+    // the player between blocks of audio without waiting on it.
+    struct Lookahead {
+      std::atomic<bool> ready;
+      std::atomic<int> next;
+    };
+
     const std::string QueueUrl();
+    int Head();
+    std::shared_ptr<Lookahead> Lookup(int);
     loftili::api::StateClient m_stateclient;
+
+    // the last queue the api gave us, kept so an unchanged queue costs a 304
+    // and a slow api doesn't stop playback of a head we already know about.
+    std::string m_etag;
+    std::string m_modified;
+    int m_head;
+    int m_next;
+    bool m_stale;
+
+    // all we read of a queue listing is the ids of its first two tracks; a
+    // queue of one leaves next at -1.
+    struct Listing {
+      int head;
+      int next;
+    };
+
+    static Listing Parse(loftili::net::HttpResponse&);
 };
 
 }
@@ -0,0 +1,49 @@
+#ifndef _LOFTILI_AUDIO_RESAMPLER_H
+#define _LOFTILI_AUDIO_RESAMPLER_H
+
+#define LOFTILI_RESAMPLE_TAPS 32
+#define LOFTILI_RESAMPLE_MAX_PHASES 1024
+#define LOFTILI_RESAMPLE_PASSBAND 0.92
+#define LOFTILI_RESAMPLE_KAISER_BETA 8.0
+
+#include <vector>
+#include <math.h>
+#include "audio/convert_kernels.h"
+
+namespace loftili {
+
+namespace audio {
+
+// changes the rate of interleaved stereo float samples by the ratio of two
+// whole numbers. the rates are reduced to up/down, and a single low pass
+// kaiser windowed sinc at up times the source rate is cut into up phases,
+// each short enough to run as one vector dot product per output frame. the
+// last few input frames are carried from one call to the next, so a stream
+// fed in pieces comes out as if it had been fed whole.
+class Resampler {
+  public:
+    Resampler() : m_kernels(&loftili::audio::ConvertKernels::Best()), m_up(1), m_down(1), m_taps(0), m_phase(0), m_index(0) { };
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    bool Configure(long, long, const loftili::audio::ConvertKernels&);
+    size_t Process(const float*, size_t, std::vector<float>&);
+    void Reset();
+    size_t Taps() { return m_taps; }
+
+  private:
+    const loftili::audio::ConvertKernels* m_kernels;
+    std::vector<float> m_filter;
+    std::vector<float> m_history;
+    size_t m_up;
+    size_t m_down;
+    size_t m_taps;
+    size_t m_phase;
+    size_t m_index;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef _LOFTILI_AUDIO_TRACK_H
+#define _LOFTILI_AUDIO_TRACK_H
+
+#define LOFTILI_FEED_READ_SIZE 16384
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mpg123.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+#include "net/url.h"
+#include "net/reactor.h"
+#include "net/http_transfer.h"
+#include "net/http_request.h"
+#include "api/device_headers.h"
+#include "audio/feed_buffer.h"
+#include "audio/track_cache.h"
+
+namespace loftili {
+
+namespace audio {
+
+// one stream being downloaded and decoded, or a cached copy of one. the download runs on the
+// reactor from the moment the track is opened, so a track can be opened well
+// before it is needed and primed (format known, decoder positioned at the
+// first frame) without ever holding up whatever is playing at the time.
+class Track {
+  public:
+    Track();
+    Track(const Track&) = delete;
+    Track& operator=(const Track&) = delete;
+    ~Track();
+
+    bool Open(const std::string&, int, loftili::audio::TrackCache*, mpg123_handle*);
+    bool Load(const std::string&, int, mpg123_handle*);
+    mpg123_handle* Release();
+    bool Prime(bool);
+    int Read(unsigned char*, size_t, size_t*);
+    void Abandon();
+
+    bool Primed() { return m_primed; }
+    bool Downloaded() { return m_download->feed.Ok(); }
+    bool Cached() { return m_cached; }
+    int Id() { return m_id; }
+    bool Failed() { return m_download->feed.Finished() && !m_download->feed.Ok(); }
+    bool TimedOut() { return m_download->timed_out; }
+    int Status() { return m_download->status; }
+    size_t OutBlock() { return mpg123_outblock(m_handle); }
+    const std::string& Url() { return m_url; }
+
+    long rate;
+    int channels;
+    int encoding;
+
+  private:
+    // what the download shares with the reactor, which may still be winding
+    // it down after the track has gone. only the feed and the results are
+    // touched off the reactor thread.
+    struct Download {
+      loftili::audio::FeedBuffer feed;
+      std::shared_ptr<loftili::net::HttpTransfer> transfer;
+      std::unique_ptr<loftili::audio::TrackCache::Writer> writer;
+      std::atomic<int> status;
+      std::atomic<bool> timed_out;
+    };
+
+    static void Request(std::shared_ptr<Download>, const std::string&, int, loftili::audio::TrackCache*);
+    int Feed();
+
+    mpg123_handle* m_handle;
+    std::shared_ptr<Download> m_download;
+    std::string m_url;
+    loftili::audio::TrackCache* m_cache;
+    std::vector<unsigned char> m_input;
+    int m_id;
+    bool m_cached;
+    bool m_primed;
+    bool m_started;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef _LOFTILI_AUDIO_TRACK_CACHE_H
+#define _LOFTILI_AUDIO_TRACK_CACHE_H
+
+#define LOFTILI_CACHE_SLOTS 1024
+#define LOFTILI_CACHE_MAGIC 0x4c465443
+#define LOFTILI_CACHE_VERSION 1
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+
+namespace loftili {
+
+namespace audio {
+
+// downloaded tracks, kept on disk between plays. each file is named after the
+// sha-256 of its contents, and an index of fixed size records maps track ids
+// onto them. the index is mapped into memory as it sits on disk, so it is
+// read once on startup and every update to it lands in the file as it is
+// made. a file is written under a temporary name and renamed into place
+// before any record points at it, and a record is only marked used once
+// everything else in it is written; a crash at any point leaves either the
+// old entry, the new one, or a stray file that the next startup removes.
+// the least recently played tracks are dropped once the byte budget is hit.
+class TrackCache {
+  public:
+    TrackCache() : m_index(NULL), m_handle(-1), m_budget(0), m_bytes(0) { };
+    TrackCache(const TrackCache&) = delete;
+    TrackCache& operator=(const TrackCache&) = delete;
+    ~TrackCache();
+
+    bool Open(const std::string& path = LOFTILI_CACHE_PATH, long budget = LOFTILI_CACHE_BYTES);
+    bool Find(int, std::string&);
+
+    // takes a track as it downloads, hashing it on the way to a temporary
+    // file; committing moves it into the cache, anything else throws it away.
+    class Writer {
+      public:
+        Writer(loftili::audio::TrackCache&, int, int, const std::string&);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer();
+        bool Write(const char*, size_t);
+        bool Commit();
+      private:
+        loftili::audio::TrackCache& m_cache;
+        EVP_MD_CTX* m_digest;
+        std::string m_path;
+        uint64_t m_size;
+        int m_track;
+        int m_handle;
+    };
+
+    std::unique_ptr<loftili::audio::TrackCache::Writer> Insert(int);
+
+  private:
+    struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t slots;
+      uint32_t reserved;
+      uint64_t clock;
+    };
+
+    // track is written last and cleared first, so a slot with a track id
+    // in it always describes a file that is in place.
+    struct Record {
+      int32_t track;
+      uint32_t reserved;
+      uint64_t size;
+      uint64_t used;
+      unsigned char hash[32];
+    };
+
+    struct Index {
+      Header header;
+      Record records[LOFTILI_CACHE_SLOTS];
+    };
+
+    bool Store(int, const std::string&, const unsigned char*, uint64_t);
+    void Evict(Record&);
+    void Sweep();
+    void Sync();
+    void Hit(int, bool);
+    std::string FilePath(const unsigned char*);
+    static bool Ours(const std::string&);
+    bool Shared(const unsigned char*, const Record*);
+
+    Index* m_index;
+    int m_handle;
+    long m_budget;
+    long m_bytes;
+    std::string m_path;
+    std::mutex m_mutex;
+};
+
+}
+
+}
+
+#endif
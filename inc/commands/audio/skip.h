@@ -17,8 +17,8 @@ namespace audio {
 
 class Skip : public loftili::net::Command {
   public:
-    void Execute(loftili::Engine*);
-    void operator ()(loftili::Engine*);
+    void Execute(loftili::Engine*, const std::string&);
+    void operator ()(loftili::Engine*, const std::string&);
 };
 
 }
@@ -2,52 +2,73 @@
 #define _LOFTILI_ENGINE_H
 
 #define MAX_ENGINE_RETRIES 10000
+#define LOFTILI_METRICS_REPORT_MS 300000
 
 #include <iostream>
+#include <chrono>
 #include <thread>
+#include <functional>
 #include <unistd.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "loftili.h"
 #include "spdlog/spdlog.h"
 #include "net/tcp_socket.h"
 #include "net/http_request.h"
+#include "api/device_headers.h"
+#include "api/credential_store.h"
+#include "lib/metrics.h"
 #include "net/http_client.h"
 #include "net/command_stream.h"
+#include "net/reactor.h"
+#include "net/heartbeat.h"
+#include "net/reconnect_policy.h"
 #include "net/generic_command.h"
 
 namespace loftili {
 
 class Engine {
   public:
-    Engine() : m_socket(loftili::net::TcpSocket(false)) { };
-    Engine(const Engine&) = default;
-    Engine& operator=(const Engine&) = default;
+    Engine() : m_socket(loftili::net::TcpSocket(false)), m_subscribed(false), m_result(0) { };
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
     ~Engine() = default;
     int Initialize(int, char*[]);
     int Run();
-    int Register();
     template <class T>
     T* Get() {
       return m_components.Field<T>();
     };
 
   private:
-    int Subscribe();
+    // told on the reactor thread whether a step that has to wait on the api worked
+    typedef std::function<void(bool)> Completion;
+
+    void Start();
+    void Register(Completion);
+    void Subscribe(Completion);
+    bool Announce();
+    void Subscribed(bool);
     int DisplayHelp();
+    int Benchmark();
+    std::string ApiUrl(const char*);
     bool KeepAlive();
-
-    enum ENGINE_STATE {
-      ENGINE_STATE_READING,
-      ENGINE_STATE_ERRORED
-    };
-
-    ENGINE_STATE m_state;
+    void RenderPing();
+    void Reauthorize(Completion);
+    void Receive();
+    void Reconnect();
 
     loftili::ComponentHierarchy m_components;
     loftili::net::TcpSocket m_socket;
-    std::thread m_thread;
-    std::mutex m_mutex;
+    loftili::net::CommandStream m_stream;
+    loftili::net::Heartbeat m_heartbeat;
+    loftili::net::ReconnectPolicy m_policy;
+    loftili::api::CredentialStore m_store;
+    std::string m_ping;
+    std::chrono::steady_clock::time_point m_boot;
+    bool m_subscribed;
+    int m_result;
 };
 
 }
@@ -0,0 +1,35 @@
+#ifndef _LOFTILI_LIB_BACKOFF_H
+#define _LOFTILI_LIB_BACKOFF_H
+
+#include <random>
+#include <algorithm>
+
+namespace loftili {
+
+namespace lib {
+
+// exponential backoff with full jitter: the n-th delay is drawn uniformly from
+// [0, min(cap, base * 2^n)], so clients that failed together retry apart.
+class Backoff {
+  public:
+    Backoff(int, int);
+    Backoff(const Backoff&) = default;
+    Backoff& operator=(const Backoff&) = default;
+    ~Backoff() = default;
+
+    int Next();
+    void Reset();
+    int Attempts() { return m_attempts; }
+
+  private:
+    std::mt19937 m_random;
+    int m_base;
+    int m_cap;
+    int m_attempts;
+};
+
+}
+
+}
+
+#endif
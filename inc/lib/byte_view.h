@@ -0,0 +1,35 @@
+#ifndef _LOFTILI_LIB_BYTE_VIEW_H
+#define _LOFTILI_LIB_BYTE_VIEW_H
+
+#include <stddef.h>
+#include <string.h>
+
+namespace loftili {
+
+namespace lib {
+
+// a non-owning window onto bytes held by someone else; the owner must outlive it.
+class ByteView {
+  public:
+    ByteView() : m_data(0), m_size(0) { };
+    ByteView(const char *data, size_t size) : m_data(data), m_size(size) { };
+    ByteView(const ByteView&) = default;
+    ByteView& operator=(const ByteView&) = default;
+    ~ByteView() = default;
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+  private:
+    const char *m_data;
+    size_t m_size;
+};
+
+}
+
+}
+
+#endif
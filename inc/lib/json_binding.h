@@ -0,0 +1,281 @@
+#ifndef _LOFTILI_LIB_JSON_BINDING_H
+#define _LOFTILI_LIB_JSON_BINDING_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include "rapidjson/reader.h"
+#include "lib/json_parser.h"
+
+#define LOFTILI_JSON_PATH_SEPARATOR '.'
+
+namespace loftili {
+
+namespace lib {
+
+// a sax handler that writes straight into the members of a T. fields are
+// declared by their key path ("token", "queue.0.id") and a member pointer, so
+// the type of each field is checked when the binding is compiled. parsing
+// stops as soon as every required field has been seen; nothing past that
+// point is read and no document is ever built.
+//
+// paths are split into a tree when they are bound. while reading, each open
+// container remembers which node of that tree it is (or that it is none), so
+// a key is only compared against the children of its container, an array
+// element is matched by its position alone, and anything outside the bound
+// paths is skipped without looking at it again.
+//
+//   loftili::lib::JsonBinding<DeviceCredentials> binding(credentials);
+//   binding.Bind("token", &DeviceCredentials::token)
+//          .Bind("device", &DeviceCredentials::device_id);
+//   binding.Parse(stream);
+template <class T>
+class JsonBinding : public loftili::lib::JsonParser {
+  public:
+    explicit JsonBinding(T& target) : m_target(target), m_current(0), m_required(0), m_found(0), m_rejected(false) {
+      Node root = {std::string(), -1, -1, std::vector<int>()};
+      m_nodes.push_back(root);
+    };
+    JsonBinding(const JsonBinding&) = delete;
+    JsonBinding& operator=(const JsonBinding&) = delete;
+    ~JsonBinding() = default;
+
+    JsonBinding& Bind(const char* path, int T::*member, bool required = true) {
+      Field f(required);
+      f.as_int = member;
+      return Add(path, f);
+    };
+
+    JsonBinding& Bind(const char* path, std::string T::*member, bool required = true) {
+      Field f(required);
+      f.as_string = member;
+      return Add(path, f);
+    };
+
+    JsonBinding& Bind(const char* path, bool T::*member, bool required = true) {
+      Field f(required);
+      f.as_bool = member;
+      return Add(path, f);
+    };
+
+    // runs rapidjson over any of its input streams, so the body can be read
+    // from the response buffer as it sits. true if every required field was
+    // found, whether or not the reader had to be cut short to get there.
+    template <class Stream>
+    bool Parse(Stream& stream) {
+      rapidjson::Reader reader;
+      reader.Parse<0, Stream, loftili::lib::JsonBinding<T> >(stream, *this);
+      return Complete();
+    };
+
+    // false as well once a bound int was given a number it can not hold
+    bool Complete() const {
+      return !m_rejected && m_found == m_required;
+    };
+
+    bool Null() {
+      Enter();
+      return true;
+    };
+
+    bool Bool(bool value) {
+      Enter();
+      Field* f = Match();
+      if(f && f->as_bool) m_target.*(f->as_bool) = value;
+      return Found(f && f->as_bool ? f : nullptr);
+    };
+
+    bool Int(int value) {
+      Enter();
+      Field* f = Match();
+      if(f && f->as_int) m_target.*(f->as_int) = value;
+      return Found(f && f->as_int ? f : nullptr);
+    };
+
+    bool Uint(unsigned value) {
+      return value > (unsigned) INT_MAX ? Wide() : Int((int) value);
+    };
+
+    bool Int64(int64_t value) {
+      return value > INT_MAX || value < INT_MIN ? Wide() : Int((int) value);
+    };
+
+    bool Uint64(uint64_t value) {
+      return value > (uint64_t) INT_MAX ? Wide() : Int((int) value);
+    };
+
+    bool Double(double) {
+      Enter();
+      return true;
+    };
+
+    bool String(const char* value, size_t length, bool) {
+      Enter();
+      Field* f = Match();
+      if(f && f->as_string) (m_target.*(f->as_string)).assign(value, length);
+      return Found(f && f->as_string ? f : nullptr);
+    };
+
+    bool StartObject() {
+      return Open(false);
+    };
+
+    bool Key(const char* value, size_t length, bool) {
+      m_current = -1;
+      int parent = m_frames.back().node;
+      if(parent < 0) return true;
+      for(int child : m_nodes[parent].children) {
+        const std::string& key = m_nodes[child].key;
+        if(key.size() == length && memcmp(key.data(), value, length) == 0) {
+          m_current = child;
+          break;
+        }
+      }
+      return true;
+    };
+
+    bool EndObject(size_t) {
+      return Close();
+    };
+
+    bool StartArray() {
+      return Open(true);
+    };
+
+    bool EndArray(size_t) {
+      return Close();
+    };
+
+  private:
+    struct Field {
+      explicit Field(bool r) : required(r), bound(false),
+        as_int(nullptr), as_string(nullptr), as_bool(nullptr) { };
+      bool required;
+      bool bound;
+      int T::*as_int;
+      std::string T::*as_string;
+      bool T::*as_bool;
+    };
+
+    // one per path segment. a segment made of digits can name an array
+    // element as well as an object key, so its position is kept alongside.
+    struct Node {
+      std::string key;
+      long index;
+      int field;
+      std::vector<int> children;
+    };
+
+    // one per open object or array; node is -1 when the container is not on
+    // any bound path.
+    struct Frame {
+      bool array;
+      long index;
+      int node;
+    };
+
+    JsonBinding& Add(const char* path, const Field& field) {
+      int node = 0;
+      const char* segment = path;
+
+      while(true) {
+        const char* end = strchr(segment, LOFTILI_JSON_PATH_SEPARATOR);
+        if(end == nullptr) end = segment + strlen(segment);
+        node = Child(node, std::string(segment, end - segment));
+        if(*end == '\0') break;
+        segment = end + 1;
+      }
+
+      if(m_nodes[node].field >= 0) return *this;
+      if(field.required) m_required++;
+      m_nodes[node].field = m_fields.size();
+      m_fields.push_back(field);
+      return *this;
+    };
+
+    int Child(int parent, const std::string& key) {
+      for(int child : m_nodes[parent].children)
+        if(m_nodes[child].key == key) return child;
+
+      char* rest = nullptr;
+      long index = key.size() > 0 && isdigit((unsigned char) key[0]) ? strtol(key.c_str(), &rest, 10) : -1;
+      Node node = {key, rest && *rest == '\0' ? index : -1, -1, std::vector<int>()};
+      m_nodes.push_back(node);
+      m_nodes[parent].children.push_back(m_nodes.size() - 1);
+      return m_nodes.size() - 1;
+    };
+
+    // values inside an array are named by their position
+    void Enter() {
+      if(m_frames.empty()) {
+        m_current = 0;
+        return;
+      }
+
+      Frame& top = m_frames.back();
+      if(!top.array) return;
+      long index = top.index++;
+      m_current = -1;
+      if(top.node < 0) return;
+
+      for(int child : m_nodes[top.node].children) {
+        if(m_nodes[child].index == index) {
+          m_current = child;
+          return;
+        }
+      }
+    };
+
+    bool Open(bool array) {
+      Enter();
+      Frame frame = {array, 0, m_current};
+      m_frames.push_back(frame);
+      return true;
+    };
+
+    bool Close() {
+      m_frames.pop_back();
+      return true;
+    };
+
+    Field* Match() {
+      if(m_current < 0 || m_nodes[m_current].field < 0) return nullptr;
+      Field* f = &m_fields[m_nodes[m_current].field];
+      return f->bound ? nullptr : f;
+    };
+
+    // a number too wide for an int; fatal only if it was meant for a field
+    bool Wide() {
+      Enter();
+      if(Match() == nullptr) return true;
+      m_rejected = true;
+      return false;
+    };
+
+    // returning false is how rapidjson is told to stop reading
+    bool Found(Field* f) {
+      if(!f) return true;
+      f->bound = true;
+      if(f->required) m_found++;
+      return !(m_required > 0 && Complete());
+    };
+
+    T& m_target;
+    std::vector<Field> m_fields;
+    std::vector<Node> m_nodes;
+    std::vector<Frame> m_frames;
+    int m_current;
+    int m_required;
+    int m_found;
+    bool m_rejected;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _LOFTILI_LIB_METRICS_H
+#define _LOFTILI_LIB_METRICS_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include "config.h"
+#include "spdlog/spdlog.h"
+
+namespace loftili {
+
+namespace lib {
+
+class Metrics {
+  public:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    ~Metrics() = default;
+
+    long Increment(const std::string&, long amount = 1);
+    void Set(const std::string&, long);
+    long Get(const std::string&);
+    void Report();
+
+  private:
+    std::map<std::string, long> m_values;
+    std::mutex m_mutex;
+};
+
+extern loftili::lib::Metrics metrics;
+
+}
+
+}
+
+#endif
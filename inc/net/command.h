@@ -1,6 +1,7 @@
 #ifndef _LOFTILI_NET_COMMAND_H
 #define _LOFTILI_NET_COMMAND_H
 
+#include <string>
 #include "lib/command.h"
 
 namespace loftili {
@@ -13,8 +14,10 @@ class Command : public loftili::lib::Command {
   public:
     virtual ~Command() { };
     void Execute() { };
-    virtual void Execute(Engine*) = 0;
-    virtual void operator ()(Engine*) = 0;
+    // the arguments are whatever followed the command's name in its message,
+    // empty when there were none.
+    virtual void Execute(Engine*, const std::string&) = 0;
+    virtual void operator ()(Engine*, const std::string&) = 0;
 };
 
 }
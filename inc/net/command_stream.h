@@ -3,32 +3,50 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include <vector>
+#include <algorithm>
 #include "config.h"
 #include "spdlog/spdlog.h"
 #include "loftili.h"
 #include "net/tcp_socket.h"
+#include "net/socket_reader.h"
 #include "net/generic_command.h"
-#include "commands/audio/start.h"
-#include "commands/audio/skip.h"
 
 namespace loftili {
 
 namespace net {
 
+// frames the subscription socket into commands. the server writes messages of
+// the form "CMD namespace:verb", ended by a newline or simply followed by the
+// next message, and the responses to our keep-alive pings arrive on the same
+// socket; those are skipped whole and only counted. partial messages wait in
+// the reader's buffer for the next read.
 class CommandStream {
   public:
-    CommandStream() = default;
+    CommandStream() : m_pongs(0), m_status(0) { };
     ~CommandStream() = default;
     CommandStream(const CommandStream&) = default;
     CommandStream& operator=(const CommandStream&) = default;
 
     bool operator<<(loftili::net::TcpSocket&);
-    const std::shared_ptr<loftili::net::GenericCommand> Latest();
+    loftili::net::GenericCommand& Latest();
     void Pop();
+    size_t Size();
+    int Pongs() { return m_pongs; }
+    int Status() { return m_status; }
 
   private:
-    std::vector<std::shared_ptr<loftili::net::GenericCommand>> m_commands;
+    void Frame(bool);
+    int FrameCommand(const char*, const char*, bool);
+    int FrameResponse(const char*, const char*);
+    int Resync(const char*, const char*);
+
+    std::vector<loftili::net::GenericCommand> m_commands;
+    loftili::net::SocketReader m_reader;
+    int m_pongs;
+    int m_status;
 
 };
 
@@ -0,0 +1,66 @@
+#ifndef _LOFTILI_NET_COMMAND_TABLE_H
+#define _LOFTILI_NET_COMMAND_TABLE_H
+
+#define LOFTILI_COMMAND_HASH_OFFSET 2166136261u
+#define LOFTILI_COMMAND_HASH_PRIME 16777619u
+#define LOFTILI_COMMAND_TABLE_EXTRA 16
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/byte_view.h"
+#include "net/command.h"
+#include "commands/audio/start.h"
+#include "commands/audio/stop.h"
+#include "commands/audio/skip.h"
+
+namespace loftili {
+
+namespace net {
+
+// fnv-1a over "namespace:verb"; constexpr so names known at build time cost
+// nothing to hash, e.g. as case labels.
+constexpr uint32_t CommandHash(const char *name, uint32_t hash = LOFTILI_COMMAND_HASH_OFFSET) {
+  return *name ? CommandHash(name + 1, (hash ^ (uint8_t) *name) * LOFTILI_COMMAND_HASH_PRIME) : hash;
+}
+
+uint32_t CommandHash(const loftili::lib::ByteView&);
+
+// maps "namespace:verb" to the command that handles it. commands are stateless
+// singletons, so the same instance serves every message naming it.
+//
+// the built in commands sit in a constexpr array sorted by hash, checked for
+// order and collisions when it is compiled. Register adds others at startup,
+// before the engine starts reading, into a small fixed array kept sorted the
+// same way; a lookup is a binary search of each. names are not copied, so a
+// registered name has to outlive the table.
+class CommandTable {
+  public:
+    struct Entry {
+      uint32_t hash;
+      const char *name;
+      loftili::net::Command *command;
+    };
+
+    CommandTable() : m_count(0) { };
+    CommandTable(const CommandTable&) = delete;
+    CommandTable& operator=(const CommandTable&) = delete;
+    ~CommandTable() = default;
+
+    bool Register(const char*, loftili::net::Command*);
+    loftili::net::Command* Find(const loftili::lib::ByteView&);
+
+  private:
+    Entry m_extra[LOFTILI_COMMAND_TABLE_EXTRA];
+    int m_count;
+};
+
+extern loftili::net::CommandTable dispatch;
+
+}
+
+}
+
+#endif
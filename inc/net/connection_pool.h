@@ -0,0 +1,70 @@
+#ifndef _LFTNET_CONNECTION_POOL_H
+#define _LFTNET_CONNECTION_POOL_H
+
+#define LOFTILI_POOL_MAX_IDLE_MS 4000
+#define LOFTILI_POOL_MAX_PER_HOST 4
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <functional>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+#include "net/tcp_socket.h"
+#include "net/reactor.h"
+
+namespace loftili {
+
+namespace net {
+
+// keeps connected http/1.1 sockets around after their response has been read so
+// the next request to the same host can skip dns, tcp and tls setup. idle sockets
+// are dropped before the server is likely to have closed them on its side.
+class ConnectionPool {
+  public:
+    // told 0 with a connected socket and whether it came from the pool, or
+    // the error connecting failed with.
+    typedef std::function<void(int, loftili::net::TcpSocket, bool)> Acquired;
+
+    ConnectionPool();
+    ConnectionPool(int, size_t);
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+    ~ConnectionPool() = default;
+
+    void Acquire(loftili::net::Reactor&, const std::string&, int, bool, const loftili::net::Deadlines&, Acquired);
+    void Release(const std::string&, int, bool, loftili::net::TcpSocket&);
+    void Evict();
+    long Hits() { return m_hits; }
+    long Misses() { return m_misses; }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+      loftili::net::TcpSocket socket;
+      Clock::time_point idle_since;
+    };
+
+    std::string Key(const std::string&, int, bool);
+    void EvictLocked(Clock::time_point);
+
+    std::map<std::string, std::vector<Entry> > m_idle;
+    std::mutex m_mutex;
+    int m_max_idle_ms;
+    size_t m_max_per_host;
+    long m_hits;
+    long m_misses;
+};
+
+extern loftili::net::ConnectionPool connections;
+
+}
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef _LFTNET_CONNECTOR_H
+#define _LFTNET_CONNECTOR_H
+
+#define LOFTILI_CONNECT_ATTEMPT_DELAY_MS 250
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "net/resolver.h"
+#include "net/deadline.h"
+#include "net/reactor.h"
+
+namespace loftili {
+
+namespace net {
+
+// opens a tcp connection to a host name using happy eyeballs: addresses of
+// both families are interleaved and each attempt gets a short head start
+// before the next one is raced against it. the first to connect wins. the
+// attempts are watched by the reactor, and the winning handle is handed over
+// still non-blocking and no longer watched.
+class Connector {
+  public:
+    typedef std::function<void(int)> Connected;
+
+    Connector() = default;
+    Connector(const Connector&) = default;
+    Connector& operator=(const Connector&) = default;
+    ~Connector() = default;
+
+    void Connect(loftili::net::Reactor&, const std::string&, int, const loftili::net::Deadline&, Connected);
+
+  private:
+    struct Race {
+      loftili::net::Reactor *reactor;
+      std::string host;
+      int port;
+      std::vector<ResolvedAddress> addresses;
+      size_t next;
+      std::vector<int> pending;
+      int attempt_timer;
+      int deadline_timer;
+      bool done;
+      Connected connected;
+    };
+
+    static void Begin(std::shared_ptr<Race>);
+    static void Launch(std::shared_ptr<Race>);
+    static void Settle(std::shared_ptr<Race>, int);
+    static void Finish(std::shared_ptr<Race>, int);
+    static void Interleave(std::vector<ResolvedAddress>&);
+    static int Start(const ResolvedAddress&);
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _LFTNET_DEADLINE_H
+#define _LFTNET_DEADLINE_H
+
+#define LOFTILI_SOCKET_TIMEOUT -3
+#define LOFTILI_TIMEOUT_CONNECT_MS 5000
+#define LOFTILI_TIMEOUT_HANDSHAKE_MS 5000
+#define LOFTILI_TIMEOUT_FIRST_BYTE_MS 10000
+#define LOFTILI_TIMEOUT_IDLE_MS 15000
+#define LOFTILI_TIMEOUT_TOTAL_MS 0
+
+#include <chrono>
+#include <algorithm>
+
+namespace loftili {
+
+namespace net {
+
+// per request limits in milliseconds, each measured from the start of its phase
+// (the total from when the request is sent). idle bounds each wait for more of
+// a response once some of it has arrived, so a body that stalls part way
+// gives up even with no total. zero or less means no limit.
+struct Deadlines {
+  int connect;
+  int handshake;
+  int first_byte;
+  int idle;
+  int total;
+};
+
+extern const loftili::net::Deadlines default_deadlines;
+
+// a fixed point in time that blocking socket calls must give up by.
+class Deadline {
+  public:
+    Deadline();
+    Deadline(int);
+    Deadline(const Deadline&) = default;
+    Deadline& operator=(const Deadline&) = default;
+    ~Deadline() = default;
+
+    int Remaining() const;
+    bool Expired() const;
+    bool Never() const { return m_never; }
+    static Deadline Sooner(const Deadline&, const Deadline&);
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point m_at;
+    bool m_never;
+};
+
+}
+
+}
+
+#endif
@@ -5,12 +5,12 @@
 #include <string.h>
 #include <iostream>
 #include <memory>
+#include <algorithm>
 #include "config.h"
 #include "spdlog/spdlog.h"
-#include "commands/audio/start.h"
-#include "commands/audio/stop.h"
-#include "commands/audio/skip.h"
+#include "lib/byte_view.h"
 #include "net/command.h"
+#include "net/command_table.h"
 
 namespace loftili {
 
@@ -18,17 +18,25 @@ class Engine;
 
 namespace net {
 
+// one framed "CMD namespace:verb [arguments]" message, resolved against the
+// dispatch table. the command it points at is shared, never owned.
 class GenericCommand : public loftili::net::Command {
   public:
     GenericCommand();
     GenericCommand(const char*);
-    ~GenericCommand();
-    void Execute(loftili::Engine*);
-    void operator()(loftili::Engine*);
+    GenericCommand(const loftili::lib::ByteView&);
+    GenericCommand(const GenericCommand&) = default;
+    GenericCommand& operator=(const GenericCommand&) = default;
+    ~GenericCommand() = default;
+    void Execute(loftili::Engine*, const std::string&);
+    void operator()(loftili::Engine*, const std::string&);
     operator bool();
+    const std::string& Arguments() { return m_arguments; }
+    static bool Known(const char*, int);
   private:
-    void AudioCommand(std::string);
+    static bool Parse(const loftili::lib::ByteView&, loftili::lib::ByteView&, loftili::lib::ByteView&);
     loftili::net::Command* m_cmd;
+    std::string m_arguments;
 };
 
 }
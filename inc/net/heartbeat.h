@@ -0,0 +1,74 @@
+#ifndef _LFTNET_HEARTBEAT_H
+#define _LFTNET_HEARTBEAT_H
+
+#define LOFTILI_HEARTBEAT_MIN_MS 5000
+#define LOFTILI_HEARTBEAT_MAX_MS 30000
+#define LOFTILI_HEARTBEAT_PONG_TIMEOUT_MS 10000
+#define LOFTILI_HEARTBEAT_DOUBT_MS 2000
+#define LOFTILI_HEARTBEAT_RECOVER_BEATS 10
+
+#include <deque>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+#include "net/reactor.h"
+
+namespace loftili {
+
+namespace net {
+
+// keeps the subscription socket provably alive with as few pings as possible.
+// a ping only goes out once the link has been quiet for the current interval,
+// which starts short and stretches while pongs keep coming back. when an idle
+// link dies the idle time it survived becomes a ceiling for the interval, so
+// a nat that drops quiet flows is pinged just inside its timeout from then on.
+// the ceiling is probed upwards again, an eighth at a time, once enough beats
+// in a row have survived at it, so one bad path doesn't pin it low for good.
+// a ping that is slow to come back makes the link doubtful, which the owner
+// hears about once per ping; one left unanswered for too long declares the
+// link dead.
+class Heartbeat {
+  public:
+    typedef std::function<bool()> Sender;
+    typedef std::function<void()> Listener;
+
+    Heartbeat();
+    Heartbeat(const Heartbeat&) = delete;
+    Heartbeat& operator=(const Heartbeat&) = delete;
+    ~Heartbeat() = default;
+
+    void Start(loftili::net::Reactor&, Sender, Listener, Listener);
+    void Stop();
+    void Lost();
+    void Activity();
+    void Pong();
+    int Interval() { return m_interval; }
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+    void Arm(int);
+    void Tick();
+    int Since(Clock::time_point);
+
+    loftili::net::Reactor *m_reactor;
+    Sender m_sender;
+    Listener m_dead;
+    Listener m_doubt;
+    std::deque<Clock::time_point> m_outstanding;
+    Clock::time_point m_last_activity;
+    int m_timer;
+    int m_quiet;
+    int m_interval;
+    int m_ceiling;
+    int m_steady;
+    bool m_doubted;
+};
+
+}
+
+}
+
+#endif
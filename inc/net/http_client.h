@@ -3,25 +3,36 @@
 
 #include <memory>
 #include <vector>
-#include "net/tcp_socket.h"
+#include <future>
+#include <utility>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "net/reactor.h"
+#include "net/connection_pool.h"
 #include "net/http_request.h"
 #include "net/http_parser.h"
 #include "net/http_response.h"
+#include "net/http_transfer.h"
 
 namespace loftili {
 
 namespace net {
 
+// sends requests for threads other than the reactor's: each is handed to the
+// reactor as a transfer, and Send waits for it to hand back the response. the
+// reactor thread itself starts a HttpTransfer instead.
 class HttpClient {
   public:
-    HttpClient() = default;
+    HttpClient() : m_timed_out(false) { };
     HttpClient(const HttpClient&) = default;
     ~HttpClient() = default;
     HttpClient& operator=(const HttpClient&) = default;
     bool Send(HttpRequest&);
+    bool Send(HttpRequest&, loftili::net::HttpBodyCallback);
     std::shared_ptr<loftili::net::HttpResponse> Latest();
+    bool TimedOut() { return m_timed_out; }
   private:
-    loftili::net::HttpParser m_parser;
+    bool m_timed_out;
     std::vector< std::shared_ptr<loftili::net::HttpResponse> > m_responses;
 };
 
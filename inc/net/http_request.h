@@ -1,17 +1,26 @@
 #ifndef _LFTNET_HTTP_REQUEST_H
 #define _LFTNET_HTTP_REQUEST_H
 
+#define LOFTILI_REQUEST_MAX_BUFFERS 16
+
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <sstream>
 #include <utility>
+#include <sys/uio.h>
 #include "net/url.h"
 #include "net/tcp_socket.h"
+#include "net/deadline.h"
 
 namespace loftili {
 
 namespace net {
 
+// one or more "key: value\r\n" lines rendered ahead of time and shared between
+// requests, e.g. the device token and serial sent with every api call.
+typedef std::shared_ptr<const std::string> HttpHeaderBlock;
+
 class HttpRequest {
   public:
     HttpRequest(const HttpRequest&) = default;
@@ -22,14 +31,26 @@ class HttpRequest {
     HttpRequest(const Url&, std::string);
     HttpRequest(const Url&, std::string, std::string);
     int Header(std::string, std::string);
+    int Header(HttpHeaderBlock);
+    int Buffers(struct iovec*, int);
+    size_t Size();
     operator std::string();
     const loftili::net::Url& Url() { return m_url; }
+    void Limit(const loftili::net::Deadlines& limits) { m_limits = limits; }
+    const loftili::net::Deadlines& Limits() { return m_limits; }
 
   private:
+    void Render();
     loftili::net::Url m_url;
     std::string m_method;
     std::string m_body;
-    std::vector< std::pair<std::string, std::string> > m_headers;
+    std::string m_head;
+    std::string m_headers;
+    std::string m_flat;
+    std::vector<HttpHeaderBlock> m_blocks;
+    loftili::net::Deadlines m_limits;
+    bool m_rendered;
+    int m_header_count;
 };
 
 }
@@ -2,29 +2,44 @@
 #define _LFTNET_HTTP_RESPONSE_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <iostream>
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include "lib/byte_view.h"
 
 namespace loftili {
 
 namespace net {
 
+// owns the buffer the parser received into; the body is a view onto it rather
+// than a copy, which is why responses can be moved but not copied.
 class HttpResponse {
   public:
-    HttpResponse() = default;
-    HttpResponse(const HttpResponse&) = default;
-    HttpResponse& operator=(const HttpResponse&) = default;
-    HttpResponse(const char*);
-    ~HttpResponse() = default;
-    const char* Body() { return m_body.data(); };
-    int ContentLength() { return m_body.size(); }
+    HttpResponse();
+    HttpResponse(const HttpResponse&) = delete;
+    HttpResponse& operator=(const HttpResponse&) = delete;
+    HttpResponse(HttpResponse&&);
+    HttpResponse& operator=(HttpResponse&&);
+    HttpResponse(char*, int);
+    ~HttpResponse();
+    loftili::lib::ByteView Body() { return loftili::lib::ByteView(m_data + m_body_start, m_body_size); };
+    int ContentLength() { return m_body_size; }
     int Status() { return m_status; }
+    std::string Header(std::string);
+    bool KeepAlive();
+
+    // downloads 1 MB to 100 MB responses from memory, whole and streamed, and
+    // prints how much memory each took at its peak, for -k on the command line.
+    // defined in http_response_benchmark.cpp, away from the process headers.
+    static int Benchmark();
   private:
     std::vector< std::pair<std::string, std::string> > m_headers;
-    std::vector<char> m_body;
+    char *m_data;
+    int m_body_start;
+    int m_body_size;
     int m_status;
 };
 
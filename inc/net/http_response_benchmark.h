@@ -0,0 +1,15 @@
+#ifndef _LFTNET_HTTP_RESPONSE_BENCHMARK_H
+#define _LFTNET_HTTP_RESPONSE_BENCHMARK_H
+
+#include <stdio.h>
+#include <string>
+#include <sstream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "lib/byte_view.h"
+#include "net/http_parser.h"
+#include "net/http_response.h"
+#include "net/memory_socket.h"
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef _LFTNET_HTTP_TRANSFER_H
+#define _LFTNET_HTTP_TRANSFER_H
+
+#include <memory>
+#include <string>
+#include <functional>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "net/reactor.h"
+#include "net/deadline.h"
+#include "net/tcp_socket.h"
+#include "net/connection_pool.h"
+#include "net/http_request.h"
+#include "net/http_parser.h"
+#include "net/http_response.h"
+
+namespace loftili {
+
+namespace net {
+
+// told on the reactor thread how a request went: its response, or null when
+// there isn't one, and whether that was for lack of time.
+typedef std::function<void(std::shared_ptr<loftili::net::HttpResponse>, bool)> HttpResponseCallback;
+
+// one request and its response, carried out on the reactor. the socket comes
+// from the pool or is connected without blocking, the request goes out and
+// the response comes in as the socket is ready for them, and the request's
+// deadlines are reactor timers. a pooled socket that the server closed while
+// it sat idle is swapped for a fresh one once, as long as nothing at all came
+// back on it. Start and Cancel belong to the reactor thread.
+class HttpTransfer : public std::enable_shared_from_this<HttpTransfer> {
+  public:
+    HttpTransfer(const loftili::net::HttpRequest&, loftili::net::HttpBodyCallback, loftili::net::HttpResponseCallback);
+    HttpTransfer(const HttpTransfer&) = delete;
+    HttpTransfer& operator=(const HttpTransfer&) = delete;
+    ~HttpTransfer() = default;
+
+    static std::shared_ptr<HttpTransfer> Start(const loftili::net::HttpRequest&, loftili::net::HttpBodyCallback, loftili::net::HttpResponseCallback);
+    void Cancel();
+
+  private:
+    void Acquire();
+    void Acquired(int, loftili::net::TcpSocket, bool);
+    void Ready();
+    void Send();
+    void Receive();
+    void Failed();
+    void Finish(std::shared_ptr<loftili::net::HttpResponse>);
+    void Watch(int);
+    void Unwatch();
+    void Arm(const loftili::net::Deadline&);
+
+    loftili::net::HttpRequest m_request;
+    loftili::net::HttpBodyCallback m_sink;
+    loftili::net::HttpResponseCallback m_done;
+    std::string m_host;
+    int m_port;
+    bool m_ssl;
+    std::string m_data;
+    size_t m_sent;
+    loftili::net::TcpSocket m_socket;
+    std::unique_ptr<loftili::net::HttpParser> m_parser;
+    int m_watched;
+    int m_timer;
+    int m_attempts;
+    bool m_reused;
+    bool m_timed_out;
+    bool m_finished;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef _LFTNET_MEMORY_SOCKET_H
+#define _LFTNET_MEMORY_SOCKET_H
+
+#define LOFTILI_MEMORY_SOCKET_READ 65536
+
+#include <string>
+#include <algorithm>
+#include "net/tcp_socket.h"
+
+namespace loftili {
+
+namespace net {
+
+// a socket that plays back a response held in memory, a network sized read
+// at a time, so the parser can be timed without a network in the way.
+class MemorySocket : public TcpSocket {
+  public:
+    explicit MemorySocket(const std::string& data) : TcpSocket(impl::Derived()), m_data(data), m_offset(0) { };
+    int Read(char*, int);
+    void Rewind() { m_offset = 0; }
+
+  private:
+    const std::string& m_data;
+    size_t m_offset;
+};
+
+}
+
+}
+
+#endif
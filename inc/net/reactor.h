@@ -0,0 +1,107 @@
+#ifndef _LFTNET_REACTOR_H
+#define _LFTNET_REACTOR_H
+
+#define LOFTILI_REACTOR_MAX_EVENTS 32
+
+#if defined(__linux__)
+#define LOFTILI_REACTOR_EPOLL 1
+#include <sys/epoll.h>
+#else
+#define LOFTILI_REACTOR_EPOLL 0
+#endif
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+
+namespace loftili {
+
+namespace net {
+
+// a single threaded event loop that owns every socket the process opens: the
+// command stream, api calls and track downloads. sockets are non-blocking and
+// watched for readiness (epoll on linux, poll elsewhere), and callbacks run on
+// the thread inside Run(). Watch, Timer and Cancel belong to that thread; Post
+// may be called from any thread to hand it work.
+//
+// nothing on the loop waits. other threads that need an api answer post the
+// request and wait for the loop to hand back the response, never on a socket,
+// and the loop never waits on them in turn. that leaves the audio threads,
+// waiting on the decoder's input and the device, as the only ones that block.
+// the one thing handed off is a name lookup the resolver has not cached:
+// getaddrinfo has no handle to watch, so it runs on a short-lived thread that
+// posts the answer back.
+class Reactor {
+  public:
+    enum EVENTS {
+      EVENT_READ = 1,
+      EVENT_WRITE = 2
+    };
+
+    typedef std::function<void(int)> IoCallback;
+    typedef std::function<void()> Task;
+
+    Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+    ~Reactor();
+
+    bool Watch(int, int, IoCallback);
+    bool Modify(int, int);
+    void Unwatch(int);
+    int Timer(int, Task);
+    int Timer(int, Task, int);
+    void Cancel(int);
+    bool Post(Task);
+    bool Inside();
+    void Run();
+    void Stop();
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Watcher {
+      int events;
+      IoCallback callback;
+    };
+
+    struct TimerEntry {
+      Clock::time_point due;
+      int repeat_ms;
+      Task task;
+    };
+
+    int RunTimers();
+    void RunTasks();
+    void Wake();
+
+    std::map<int, Watcher> m_watchers;
+    std::map<int, TimerEntry> m_timers;
+    std::vector<Task> m_tasks;
+    std::mutex m_task_mutex;
+    std::thread::id m_thread;
+    int m_next_timer;
+    int m_wake[2];
+    int m_poller;
+    bool m_running;
+    bool m_finished;
+};
+
+extern loftili::net::Reactor reactor;
+
+}
+
+}
+
+#endif
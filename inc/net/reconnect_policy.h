@@ -0,0 +1,67 @@
+#ifndef _LFTNET_RECONNECT_POLICY_H
+#define _LFTNET_RECONNECT_POLICY_H
+
+#define LOFTILI_RECONNECT_BASE_MS 500
+#define LOFTILI_RECONNECT_CAP_MS 30000
+#define LOFTILI_RECONNECT_STANDBY_MAX_MS 45000
+
+#include <chrono>
+#include <string>
+#include <errno.h>
+#include <sys/socket.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/backoff.h"
+#include "lib/metrics.h"
+#include "net/tcp_socket.h"
+#include "net/reactor.h"
+
+namespace loftili {
+
+namespace net {
+
+// decides when the engine tries to get its subscription back after losing it:
+// straight away the first time, then with jittered exponential backoff. while
+// the subscription looks unhealthy it also keeps a standby connection (tcp
+// and tls done, nothing sent) so that a failover only costs the SUBSCRIBE
+// write. the standby is connected on the reactor once the primary is in
+// doubt, dropped as soon as the primary answers again, and never kept past
+// the age servers or middleboxes would give up on an idle connection that
+// never sent a request.
+class ReconnectPolicy {
+  public:
+    ReconnectPolicy();
+    ReconnectPolicy(const ReconnectPolicy&) = delete;
+    ReconnectPolicy& operator=(const ReconnectPolicy&) = delete;
+    ~ReconnectPolicy() = default;
+
+    void Lost();
+    int Next();
+    void Recovered();
+    int Attempts() { return m_backoff.Attempts(); }
+
+    void Prepare(loftili::net::Reactor&, const std::string&, int, bool);
+    void Settle();
+    bool Take(loftili::net::TcpSocket&);
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+    void Discard();
+
+    loftili::lib::Backoff m_backoff;
+    bool m_lost;
+    Clock::time_point m_lost_at;
+
+    loftili::net::Reactor *m_reactor;
+    loftili::net::TcpSocket m_standby;
+    Clock::time_point m_standby_since;
+    bool m_pending;
+    bool m_wanted;
+    int m_expiry;
+};
+
+}
+
+}
+
+#endif
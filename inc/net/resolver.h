@@ -0,0 +1,66 @@
+#ifndef _LFTNET_RESOLVER_H
+#define _LFTNET_RESOLVER_H
+
+#define LOFTILI_RESOLVER_TTL_MS 60000
+#define LOFTILI_RESOLVER_NEGATIVE_TTL_MS 5000
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+
+namespace loftili {
+
+namespace net {
+
+struct ResolvedAddress {
+  sockaddr_storage address;
+  socklen_t length;
+  int family;
+};
+
+// getaddrinfo with an in-process cache shared by every thread. the system
+// resolver does not tell us record ttls, so answers are kept for a fixed time
+// and failures for a shorter one.
+class Resolver {
+  public:
+    Resolver();
+    Resolver(int, int);
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+    ~Resolver() = default;
+
+    int Resolve(const std::string&, int, std::vector<ResolvedAddress>&);
+    bool Cached(const std::string&, int, std::vector<ResolvedAddress>&);
+    void Forget(const std::string&, int);
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+      std::vector<ResolvedAddress> addresses;
+      Clock::time_point expires;
+    };
+
+    std::string Key(const std::string&, int);
+    std::map<std::string, Entry> m_cache;
+    std::mutex m_mutex;
+    int m_ttl_ms;
+    int m_negative_ttl_ms;
+};
+
+extern loftili::net::Resolver resolver;
+
+}
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _LFTNET_SOCKET_READER_H
+#define _LFTNET_SOCKET_READER_H
+
+#define LOFTILI_READER_BLOCK_SIZE 4096
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "lib/byte_view.h"
+#include "net/tcp_socket.h"
+
+namespace loftili {
+
+namespace net {
+
+// keeps whatever a socket read returned beyond what the caller asked for, so
+// framed protocols can pull out whole messages regardless of how they were
+// split across tcp segments. views returned by the reader are only valid until
+// the next call that reads from the socket.
+class SocketReader {
+  public:
+    SocketReader();
+    SocketReader(loftili::net::TcpSocket&);
+    SocketReader(const SocketReader&) = default;
+    SocketReader& operator=(const SocketReader&) = default;
+    ~SocketReader() = default;
+
+    void Attach(loftili::net::TcpSocket&);
+    int Fill();
+    int ReadUntil(const char*, loftili::lib::ByteView&);
+    int ReadExactly(int, loftili::lib::ByteView&);
+    loftili::lib::ByteView Buffered();
+    void Consume(int);
+
+  private:
+    loftili::net::TcpSocket m_socket;
+    std::vector<char> m_buffer;
+    int m_start;
+    int m_end;
+};
+
+}
+
+}
+
+#endif
@@ -8,6 +8,9 @@
 #define APPLE 0
 #endif
 
+#define LOFTILI_SOCKET_MAX_IOV 32
+#define LOFTILI_SOCKET_WOULDBLOCK -2
+#define LOFTILI_SOCKET_WANTWRITE -4
 
 #include <openssl/rand.h>
 #include <openssl/ssl.h>
@@ -15,11 +18,28 @@
 #include <memory.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <memory>
+#include <string>
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <errno.h>
+#include <vector>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "net/tls_context.h"
+#include "net/connector.h"
+#include "net/deadline.h"
+#include "net/reactor.h"
+
+#if APPLE
+#define MSG_NOSIGNAL 0
+#endif
 
 namespace loftili {
 
@@ -27,6 +47,10 @@ namespace net {
 
 namespace impl { struct Derived{}; }
 
+// told 0 once a socket is connected (and its tls handshake done), or the
+// error it failed with.
+typedef std::function<void(int)> ConnectCallback;
+
 class TcpSocket {
   public:
     TcpSocket();
@@ -35,11 +59,20 @@ class TcpSocket {
     TcpSocket& operator=(const TcpSocket&);
     TcpSocket(const TcpSocket&);
     virtual ~TcpSocket();
-    virtual int Connect(const char *, int);
+    bool operator==(const TcpSocket& other) const { return m_impl == other.m_impl; }
+    void Connect(loftili::net::Reactor&, const char *, int, ConnectCallback);
+    virtual int Adopt(int, const char *);
+    virtual int Handshake();
     virtual int Write(const char *, int);
+    virtual int Write(const struct iovec *, int);
     virtual int Read(char *, int);
+    virtual int Handle();
+    virtual void Blocking(bool);
+    virtual void Limit(const loftili::net::Deadlines&);
+    virtual loftili::net::Deadlines Limits();
+    virtual void Expires(const loftili::net::Deadline&);
   protected:
-    int m_refcount;
+    std::atomic<int> m_refcount;
     TcpSocket *m_impl;
 };
 
@@ -49,26 +82,50 @@ class SslImpl : public TcpSocket {
   public:
     SslImpl();
     ~SslImpl();
-    int Connect(const char *, int);
+    int Adopt(int, const char *);
+    int Handshake();
     int Write(const char *, int);
+    int Write(const struct iovec *, int);
     int Read(char *, int);
+    int Handle() { return m_handle; }
+    void Blocking(bool);
+    void Limit(const loftili::net::Deadlines& limits) { m_limits = limits; }
+    loftili::net::Deadlines Limits() { return m_limits; }
+    void Expires(const loftili::net::Deadline& deadline) { m_deadline = deadline; }
   private:
+    int Retry(int);
     int m_handle;
     SSL *m_ssl;
-    SSL_CTX *m_context;
+    bool m_connected;
+    bool m_blocking;
+    loftili::net::Deadlines m_limits;
+    loftili::net::Deadline m_deadline;
+    std::vector<char> m_gather;
 };
 
 class Impl : public TcpSocket {
   public:
     Impl();
     ~Impl();
-    int Connect(const char *, int);
+    int Adopt(int handle, const char *) { m_handle = handle; return 0; }
+    int Handshake() { return 0; }
     int Write(const char *, int);
+    int Write(const struct iovec *, int);
     int Read(char *, int);
+    int Handle() { return m_handle; }
+    void Blocking(bool);
+    void Limit(const loftili::net::Deadlines& limits) { m_limits = limits; }
+    loftili::net::Deadlines Limits() { return m_limits; }
+    void Expires(const loftili::net::Deadline& deadline) { m_deadline = deadline; }
   private:
     int m_handle;
+    bool m_blocking;
+    loftili::net::Deadlines m_limits;
+    loftili::net::Deadline m_deadline;
 };
 
+void Handshake(loftili::net::Reactor&, loftili::net::TcpSocket&, const std::string&, int, int, ConnectCallback);
+
 }
 
 }
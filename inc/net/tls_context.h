@@ -0,0 +1,51 @@
+#ifndef _LFTNET_TLS_CONTEXT_H
+#define _LFTNET_TLS_CONTEXT_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include "config.h"
+#include "spdlog/spdlog.h"
+#include "lib/metrics.h"
+
+namespace loftili {
+
+namespace net {
+
+// the one SSL_CTX every tls socket in the process is created from. sessions
+// the server hands out are remembered per host so later connections can
+// resume them instead of paying for a full handshake.
+class TlsContext {
+  public:
+    TlsContext();
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+    ~TlsContext();
+
+    SSL* Open(const char*);
+    void Connected(SSL*);
+    long Resumed() { return m_resumed; }
+    long Full() { return m_full; }
+
+  private:
+    void Initialize();
+    void Store(const std::string&, SSL_SESSION*);
+    static int NewSession(SSL*, SSL_SESSION*);
+
+    SSL_CTX *m_context;
+    std::once_flag m_once;
+    std::mutex m_mutex;
+    std::map<std::string, SSL_SESSION*> m_sessions;
+    long m_resumed;
+    long m_full;
+};
+
+extern loftili::net::TlsContext tls;
+
+}
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "api/credential_store.h"
+
+namespace loftili {
+
+namespace api {
+
+bool CredentialStore::Load(const std::string& serial, loftili::api::DeviceCredentials& credentials) {
+  std::ifstream file(m_path.c_str());
+  std::string stored_serial, token;
+  int device_id = -1;
+
+  if(!file.good())
+    return false;
+
+  if(!std::getline(file, stored_serial) || !(file >> device_id) || !(file >> token))
+    return false;
+
+  if(stored_serial != serial || device_id <= 0 || token.size() < 1) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("ignoring saved credentials in {0}, they belong to another device", m_path);
+    return false;
+  }
+
+  credentials.token = token;
+  credentials.device_id = device_id;
+  return true;
+}
+
+bool CredentialStore::Save(const std::string& serial, const loftili::api::DeviceCredentials& credentials) {
+  std::stringstream contents;
+  contents << serial << "\n" << credentials.device_id << "\n" << credentials.token << "\n";
+  std::string data = contents.str(), temporary = m_path + ".tmp";
+
+  int handle = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  if(handle < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to save credentials to {0}: {1}", temporary, strerror(errno));
+    return false;
+  }
+
+  bool ok = write(handle, data.c_str(), data.size()) == (ssize_t) data.size() && fsync(handle) == 0;
+  ok = close(handle) == 0 && ok;
+
+  if(!ok || rename(temporary.c_str(), m_path.c_str()) != 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to save credentials to {0}: {1}", m_path, strerror(errno));
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+void CredentialStore::Clear() {
+  unlink(m_path.c_str());
+}
+
+}
+
+}
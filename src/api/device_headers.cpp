@@ -0,0 +1,29 @@
+#include "api/device_headers.h"
+
+namespace loftili {
+
+namespace api {
+
+loftili::net::HttpHeaderBlock DeviceHeaders() {
+  static std::mutex lock;
+  static loftili::net::HttpHeaderBlock block;
+  static std::string token, serial;
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  if(block && token == loftili::api::credentials.token && serial == loftili::api::configuration.serial)
+    return block;
+
+  token = loftili::api::credentials.token;
+  serial = loftili::api::configuration.serial;
+
+  std::string rendered;
+  rendered.append(LOFTILI_API_TOKEN_HEADER).append(": ").append(token).append("\r\n");
+  rendered.append(LOFTILI_API_SERIAL_HEADER).append(": ").append(serial).append("\r\n");
+  block = std::make_shared<const std::string>(std::move(rendered));
+  return block;
+}
+
+}
+
+}
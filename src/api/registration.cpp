@@ -4,25 +4,6 @@ namespace loftili {
 
 namespace api {
 
-bool Registration::Parser::Uint(unsigned int value) {
-  if(m_current_key == "device")
-    loftili::api::credentials.device_id = value;
-
-  return true;
-};
-
-bool Registration::Parser::String(const char* value, size_t, bool) {
-  if(m_current_key == "token")
-    loftili::api::credentials.token = std::string(value);
-
-  return true;
-};
-
-bool Registration::Parser::Key(const char* value, size_t, bool) {
-  m_current_key = value;
-  return true;
-};
-
 std::string Registration::RegistrationUrl() {
   std::stringstream url;
   url << loftili::api::configuration.protocol << "://";
@@ -30,8 +11,9 @@ std::string Registration::RegistrationUrl() {
   return url.str();
 }
 
-int Registration::Register() {
-  loftili::net::HttpClient client;
+// asks the api for credentials from the reactor; done is told whether it
+// handed over a token and device id.
+void Registration::Register(std::function<void(bool)> done) {
   std::stringstream body;
   body << "{";
   body << "\"serial_number\": \"" << loftili::api::configuration.serial << "\"";
@@ -39,26 +21,27 @@ int Registration::Register() {
   loftili::net::HttpRequest req(loftili::net::Url(RegistrationUrl().c_str()), "POST", body.str());
   spdlog::get(LOFTILI_SPDLOG_ID)->info("registering serial number {0}", loftili::api::configuration.serial);
 
-  std::shared_ptr<loftili::net::HttpResponse> res;
-
-  if(!client.Send(req) || (res = client.Latest())->Status() != 200) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to send registration request to api.");
-    return 0;
-  }
-
-  loftili::api::JsonStream ss(res->Body());
-  rapidjson::Reader reader;
-  loftili::api::Registration::Parser p;
-  reader.Parse<0, loftili::api::JsonStream, loftili::api::Registration::Parser>(ss, p);
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("registration attempt complete");
-
-  if(loftili::api::credentials.token.size() < 1)
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("registration attempt failed, unable to retrieve a valid api token");
-  else
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("received token from server: {0}", loftili::api::credentials.token.c_str());
-
-
-  return loftili::api::credentials.token.size() > 0 && loftili::api::credentials.device_id > 0 ? 1 : 0;
+  loftili::net::HttpTransfer::Start(req, loftili::net::HttpBodyCallback(), [done](std::shared_ptr<loftili::net::HttpResponse> res, bool) {
+    if(!res || res->Status() != 200) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to send registration request to api.");
+      done(false);
+      return;
+    }
+
+    loftili::api::JsonStream ss(res->Body().Data());
+    loftili::lib::JsonBinding<loftili::api::DeviceCredentials> binding(loftili::api::credentials);
+    binding.Bind("token", &loftili::api::DeviceCredentials::token)
+           .Bind("device", &loftili::api::DeviceCredentials::device_id);
+    binding.Parse(ss);
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("registration attempt complete");
+
+    if(loftili::api::credentials.token.size() < 1)
+      spdlog::get(LOFTILI_SPDLOG_ID)->critical("registration attempt failed, unable to retrieve a valid api token");
+    else
+      spdlog::get(LOFTILI_SPDLOG_ID)->info("received token from server: {0}", loftili::api::credentials.token.c_str());
+
+    done(loftili::api::credentials.token.size() > 0 && loftili::api::credentials.device_id > 0);
+  });
 };
 
 }
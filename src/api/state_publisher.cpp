@@ -0,0 +1,100 @@
+#include "api/state_publisher.h"
+
+namespace loftili {
+
+namespace api {
+
+StatePublisher::StatePublisher() : m_backoff(LOFTILI_STATE_RETRY_BASE_MS, LOFTILI_STATE_RETRY_CAP_MS), m_sending(false) {
+}
+
+// may be called from any thread and never waits; the reactor takes it from here.
+void StatePublisher::Update(const std::string& key, int value) {
+  loftili::net::reactor.Post([this, key, value]() {
+    m_pending[key] = value;
+    Flush();
+  });
+}
+
+void StatePublisher::Flush() {
+  if(m_sending || m_pending.size() == 0)
+    return;
+
+  std::map<std::string, int> sending;
+  sending.swap(m_pending);
+  m_sending = true;
+
+  std::stringstream body;
+  body << "{";
+
+  for(std::map<std::string, int>::const_iterator it = sending.begin(); it != sending.end(); ++it)
+    body << (it == sending.begin() ? "" : ", ") << "\"" << it->first << "\": \"" << it->second << "\"";
+
+  body << "}";
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("attempting to update device state with {0}", body.str());
+  loftili::net::HttpRequest req(loftili::net::Url(StateUrl().c_str()), "PUT", body.str());
+  req.Header(loftili::api::DeviceHeaders());
+
+  loftili::net::Deadlines limits = loftili::net::default_deadlines;
+  limits.total = LOFTILI_STATE_TOTAL_MS;
+  req.Limit(limits);
+
+  loftili::net::HttpTransfer::Start(req, loftili::net::HttpBodyCallback(), [this, sending](std::shared_ptr<loftili::net::HttpResponse> res, bool) {
+    if(Published(res) < 0) {
+      Retry(sending);
+      return;
+    }
+
+    m_backoff.Reset();
+    m_sending = false;
+    Flush();
+  });
+}
+
+// 0 once the api has the state, 1 when it refused it for good (nothing to gain
+// from sending it again) and -1 when it is worth retrying.
+int StatePublisher::Published(std::shared_ptr<loftili::net::HttpResponse> res) {
+  if(!res)
+    return -1;
+
+  int status = res->Status();
+
+  if(status == 200) {
+    loftili::lib::metrics.Increment("api.state.puts");
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("successfully updated state");
+    return 0;
+  }
+
+  if(status >= 500 || status == 429)
+    return -1;
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->warn("device state rejected with status[{0}]", status);
+  return 1;
+}
+
+// anything updated meanwhile is newer than what failed to go out
+void StatePublisher::Retry(const std::map<std::string, int>& failed) {
+  for(std::map<std::string, int>::const_iterator it = failed.begin(); it != failed.end(); ++it)
+    m_pending.insert(*it);
+
+  int delay = m_backoff.Next();
+  loftili::lib::metrics.Increment("api.state.retries");
+  spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to update device state, retrying in [{0}]ms", delay);
+
+  loftili::net::reactor.Timer(delay, [this]() {
+    m_sending = false;
+    Flush();
+  });
+}
+
+std::string StatePublisher::StateUrl() {
+  std::stringstream ss;
+  ss << loftili::api::configuration.protocol << "://";
+  ss << loftili::api::configuration.hostname << ":" << loftili::api::configuration.port << "/devicestates/";
+  ss << loftili::api::credentials.device_id;
+  return ss.str();
+}
+
+}
+
+}
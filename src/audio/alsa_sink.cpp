@@ -0,0 +1,173 @@
+#include "audio/alsa_sink.h"
+
+#if HAVE_ALSA
+
+namespace loftili {
+
+namespace audio {
+
+AlsaSink::AlsaSink(const loftili::audio::SinkConfiguration& configuration) :
+  m_name(configuration.device.size() > 0 ? configuration.device : LOFTILI_ALSA_DEVICE),
+  m_pcm(NULL),
+  m_period(configuration.period > 0 ? configuration.period : LOFTILI_ALSA_PERIOD_FRAMES),
+  m_buffer(configuration.buffer > 0 ? configuration.buffer : LOFTILI_ALSA_BUFFER_FRAMES),
+  m_offset(0), m_frame(0), m_rate(0) {
+}
+
+AlsaSink::~AlsaSink() {
+  Close();
+}
+
+bool AlsaSink::Open(const loftili::audio::AudioFormat& format) {
+  int err = snd_pcm_open(&m_pcm, m_name.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+
+  if(err < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to open alsa device {0}: {1}", m_name, snd_strerror(err));
+    m_pcm = NULL;
+    return false;
+  }
+
+  if(!Configure(format)) {
+    Close();
+    return false;
+  }
+
+  m_frame = format.channels * format.bits / 8;
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("opened alsa device {0} at {1}hz, {2} frame periods in a {3} frame buffer", m_name, m_rate, m_period, m_buffer);
+  return true;
+}
+
+// the device may not give exactly the period or buffer asked for, so
+// whatever it settles on is read back and used from there on. the rate has
+// to be the one everything was converted to; a device that will only run at
+// another one is refused rather than played back at the wrong speed.
+bool AlsaSink::Configure(const loftili::audio::AudioFormat& format) {
+  snd_pcm_format_t sample = format.bits == 32 ? SND_PCM_FORMAT_S32 : format.bits == 8 ? SND_PCM_FORMAT_S8 : SND_PCM_FORMAT_S16;
+  snd_pcm_hw_params_t* hw = NULL;
+  snd_pcm_sw_params_t* sw = NULL;
+  m_rate = format.rate;
+  int err;
+
+  if((err = snd_pcm_hw_params_malloc(&hw)) < 0 || (err = snd_pcm_sw_params_malloc(&sw)) < 0) {
+    snd_pcm_hw_params_free(hw);
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to configure alsa device {0}: {1}", m_name, snd_strerror(err));
+    return false;
+  }
+
+  bool ok = (err = snd_pcm_hw_params_any(m_pcm, hw)) >= 0
+    && (err = snd_pcm_hw_params_set_access(m_pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) >= 0
+    && (err = snd_pcm_hw_params_set_format(m_pcm, hw, sample)) >= 0
+    && (err = snd_pcm_hw_params_set_channels(m_pcm, hw, format.channels)) >= 0
+    && (err = snd_pcm_hw_params_set_rate_near(m_pcm, hw, &m_rate, NULL)) >= 0
+    && (err = snd_pcm_hw_params_set_period_size_near(m_pcm, hw, &m_period, NULL)) >= 0
+    && (err = snd_pcm_hw_params_set_buffer_size_near(m_pcm, hw, &m_buffer)) >= 0
+    && (err = snd_pcm_hw_params(m_pcm, hw)) >= 0
+    && (err = snd_pcm_sw_params_current(m_pcm, sw)) >= 0
+    && (err = snd_pcm_sw_params_set_avail_min(m_pcm, sw, m_period)) >= 0
+    && (err = snd_pcm_sw_params_set_start_threshold(m_pcm, sw, m_buffer - m_period)) >= 0
+    && (err = snd_pcm_sw_params(m_pcm, sw)) >= 0;
+
+  snd_pcm_hw_params_free(hw);
+  snd_pcm_sw_params_free(sw);
+
+  if(!ok)
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to configure alsa device {0}: {1}", m_name, snd_strerror(err));
+
+  if(ok && m_rate != (unsigned int) format.rate) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("alsa device {0} runs at {1}hz rather than {2}hz, start with -r {1} to match it", m_name, m_rate, format.rate);
+    return false;
+  }
+
+  return ok;
+}
+
+void AlsaSink::Close() {
+  if(m_pcm == NULL) return;
+  snd_pcm_drop(m_pcm);
+  snd_pcm_close(m_pcm);
+  m_pcm = NULL;
+}
+
+// maps at most the bytes asked for, one period at a time. with less than a
+// period free it waits for the device to make room and hands back nothing,
+// which the output thread treats as a retry.
+unsigned char* AlsaSink::Begin(size_t& size) {
+  snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm);
+
+  if(avail < 0) {
+    if(!Recover((int) avail)) size = 0;
+    return NULL;
+  }
+
+  if((snd_pcm_uframes_t) avail < m_period) {
+    Idle();
+    int err = snd_pcm_wait(m_pcm, LOFTILI_ALSA_WAIT_MS);
+    if(err < 0) Recover(err);
+    size = 0;
+    return NULL;
+  }
+
+  const snd_pcm_channel_area_t* areas = NULL;
+  snd_pcm_uframes_t frames = std::min((snd_pcm_uframes_t) avail, (snd_pcm_uframes_t) (size / m_frame));
+  int err = snd_pcm_mmap_begin(m_pcm, &areas, &m_offset, &frames);
+
+  if(err < 0 || frames == 0) {
+    if(err < 0) Recover(err);
+    size = 0;
+    return NULL;
+  }
+
+  size = frames * m_frame;
+  return (unsigned char*) areas[0].addr + (areas[0].first + m_offset * areas[0].step) / 8;
+}
+
+// the start threshold is only reached by a full buffer, so anything shorter
+// (the end of a track, or a buffer the device rounded up) is started here.
+void AlsaSink::Idle() {
+  if(snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED && snd_pcm_avail_update(m_pcm) < (snd_pcm_sframes_t) m_buffer)
+    snd_pcm_start(m_pcm);
+}
+
+// blocks until the device has played everything committed, then leaves it
+// prepared for whatever is written next.
+void AlsaSink::Drain() {
+  int err = snd_pcm_drain(m_pcm);
+  if(err < 0) Recover(err);
+  snd_pcm_prepare(m_pcm);
+  m_delay = 0;
+}
+
+bool AlsaSink::Commit(size_t size) {
+  snd_pcm_sframes_t committed = snd_pcm_mmap_commit(m_pcm, m_offset, size / m_frame);
+
+  if(committed < 0 || (size_t) committed != size / m_frame)
+    return Recover(committed < 0 ? (int) committed : -EPIPE);
+
+  Measure();
+  return true;
+}
+
+void AlsaSink::Measure() {
+  snd_pcm_sframes_t frames = 0;
+  if(snd_pcm_delay(m_pcm, &frames) == 0 && frames >= 0)
+    m_delay = (long) frames * 1000 / m_rate;
+}
+
+bool AlsaSink::Recover(int err) {
+  if(err == -EPIPE) m_xruns++;
+
+  // runs on the output thread, which has nowhere to report this; backing off
+  // keeps it from spinning on a device that has gone away.
+  if(snd_pcm_recover(m_pcm, err, 1) < 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOFTILI_ALSA_WAIT_MS));
+    return false;
+  }
+
+  return true;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "audio/ao_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+AoSink::~AoSink() {
+  Close();
+}
+
+bool AoSink::Open(const loftili::audio::AudioFormat& format) {
+  ao_sample_format sample;
+  sample.bits = format.bits;
+  sample.rate = format.rate;
+  sample.channels = format.channels;
+  sample.byte_format = AO_FMT_NATIVE;
+  sample.matrix = 0;
+
+  int driver_id = ao_default_driver_id();
+  m_device = ao_open_live(driver_id, &sample, NULL);
+
+  if(m_device != NULL)
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("opened libao driver[{0}]", driver_id);
+
+  return m_device != NULL;
+}
+
+void AoSink::Close() {
+  if(m_device == NULL) return;
+  ao_close(m_device);
+  m_device = NULL;
+}
+
+bool AoSink::Play(const unsigned char* data, size_t size) {
+  return ao_play(m_device, (char*) data, size) != 0;
+}
+
+}
+
+}
@@ -0,0 +1,44 @@
+#include "audio/audio_sink.h"
+#include "audio/ao_sink.h"
+#include "audio/alsa_sink.h"
+#include "audio/file_sink.h"
+#include "audio/null_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+unsigned char* AudioSink::Begin(size_t& size) {
+  size = std::min(size, m_chunk.size());
+  return m_chunk.data();
+}
+
+bool AudioSink::Commit(size_t size) {
+  return Play(m_chunk.data(), size);
+}
+
+bool AudioSink::Known(const std::string& backend) {
+  return backend == "ao" || backend == "alsa" || backend == "file" || backend == "null";
+}
+
+AudioSink* AudioSink::Create(const loftili::audio::SinkConfiguration& configuration) {
+  if(configuration.backend == "alsa") {
+#if HAVE_ALSA
+    return new loftili::audio::AlsaSink(configuration);
+#else
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("built without alsa support, falling back to libao output");
+#endif
+  }
+
+  if(configuration.backend == "file")
+    return new loftili::audio::FileSink(configuration.device.size() > 0 ? configuration.device : LOFTILI_FILE_SINK_PATH);
+
+  if(configuration.backend == "null")
+    return new loftili::audio::NullSink();
+
+  return new loftili::audio::AoSink();
+}
+
+}
+
+}
@@ -0,0 +1,93 @@
+#include "audio/convert_kernels.h"
+
+namespace loftili {
+
+namespace audio {
+
+namespace {
+
+inline float Uniform(uint32_t& x) {
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  // the top 23 bits as the mantissa of a float in [1, 2)
+  uint32_t bits = (x >> 9) | 0x3f800000;
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value - 1.5f;
+}
+
+void S16ToFloat(const int16_t* in, float* out, size_t count) {
+  for(size_t i = 0; i < count; i++)
+    out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+void S32ToFloat(const int32_t* in, float* out, size_t count) {
+  for(size_t i = 0; i < count; i++)
+    out[i] = in[i] * (1.0f / 2147483648.0f);
+}
+
+void MonoToStereo(const float* in, float* out, size_t frames) {
+  for(size_t i = 0; i < frames; i++)
+    out[i * 2] = out[i * 2 + 1] = in[i];
+}
+
+void FloatToS16(const float* in, int16_t* out, size_t count, loftili::audio::DitherState* dither) {
+  for(size_t i = 0; i < count; i++) {
+    float sample = in[i] * 32768.0f;
+    if(dither) sample += Uniform(dither->lanes[0]) + Uniform(dither->lanes[0]);
+    out[i] = (int16_t) lrintf(std::min(32767.0f, std::max(-32768.0f, sample)));
+  }
+}
+
+void Fir(const float* x, const float* c, size_t count, float* out) {
+  float left = 0.0f, right = 0.0f;
+
+  for(size_t i = 0; i < count; i += 2) {
+    left += x[i] * c[i];
+    right += x[i + 1] * c[i + 1];
+  }
+
+  out[0] = left;
+  out[1] = right;
+}
+
+const loftili::audio::ConvertKernels scalar_kernels = {
+  "scalar", S16ToFloat, S32ToFloat, MonoToStereo, FloatToS16, Fir
+};
+
+}
+
+const loftili::audio::ConvertKernels& ConvertKernels::Scalar() {
+  return scalar_kernels;
+}
+
+// sse2 is part of every x86-64 processor, so it is known at compile time;
+// avx2 is asked of the processor. neon is always there on 64 bit arm and is
+// otherwise only built in when the compiler was told it could use it.
+std::vector<const loftili::audio::ConvertKernels*> ConvertKernels::Available() {
+  std::vector<const loftili::audio::ConvertKernels*> tables;
+  tables.push_back(&scalar_kernels);
+
+#if LOFTILI_KERNELS_X86
+  tables.push_back(&sse2_kernels);
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) tables.push_back(&avx2_kernels);
+#endif
+
+#if LOFTILI_KERNELS_NEON
+  tables.push_back(&neon_kernels);
+#endif
+
+  return tables;
+}
+
+const loftili::audio::ConvertKernels& ConvertKernels::Best() {
+  static const loftili::audio::ConvertKernels* best = Available().back();
+  return *best;
+}
+
+}
+
+}
@@ -0,0 +1,114 @@
+#include "audio/convert_kernels.h"
+
+#if LOFTILI_KERNELS_NEON
+
+namespace loftili {
+
+namespace audio {
+
+namespace {
+
+inline float32x4_t NoiseNeon(uint32x4_t& x) {
+  const uint32x4_t one = vdupq_n_u32(0x3f800000);
+  const float32x4_t half = vdupq_n_f32(1.5f);
+  float32x4_t sum = vdupq_n_f32(0.0f);
+
+  for(int i = 0; i < 2; i++) {
+    x = veorq_u32(x, vshlq_n_u32(x, 13));
+    x = veorq_u32(x, vshrq_n_u32(x, 17));
+    x = veorq_u32(x, vshlq_n_u32(x, 5));
+    sum = vaddq_f32(sum, vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(x, 9), one)), half));
+  }
+
+  return sum;
+}
+
+// 32 bit arm has no rounding conversion, so half a step is added away from
+// zero and the conversion truncates
+inline int32x4_t RoundNeon(float32x4_t x) {
+  const float32x4_t up = vdupq_n_f32(0.5f), down = vdupq_n_f32(-0.5f);
+  return vcvtq_s32_f32(vaddq_f32(x, vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), down, up)));
+}
+
+void S16ToFloatNeon(const int16_t* in, float* out, size_t count) {
+  const float scale = 1.0f / 32768.0f;
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    int16x8_t v = vld1q_s16(in + i);
+    vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+    vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+  }
+
+  loftili::audio::ConvertKernels::Scalar().s16_to_float(in + i, out + i, count - i);
+}
+
+void S32ToFloatNeon(const int32_t* in, float* out, size_t count) {
+  const float scale = 1.0f / 2147483648.0f;
+  size_t i = 0;
+
+  for(; i + 4 <= count; i += 4)
+    vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + i)), scale));
+
+  loftili::audio::ConvertKernels::Scalar().s32_to_float(in + i, out + i, count - i);
+}
+
+void MonoToStereoNeon(const float* in, float* out, size_t frames) {
+  size_t i = 0;
+
+  for(; i + 4 <= frames; i += 4) {
+    float32x4x2_t pair;
+    pair.val[0] = pair.val[1] = vld1q_f32(in + i);
+    vst2q_f32(out + i * 2, pair);
+  }
+
+  loftili::audio::ConvertKernels::Scalar().mono_to_stereo(in + i, out + i * 2, frames - i);
+}
+
+void FloatToS16Neon(const float* in, int16_t* out, size_t count, loftili::audio::DitherState* dither) {
+  const float32x4_t low = vdupq_n_f32(-32768.0f), high = vdupq_n_f32(32767.0f);
+  uint32x4_t state = dither ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    float32x4_t a = vmulq_n_f32(vld1q_f32(in + i), 32768.0f);
+    float32x4_t b = vmulq_n_f32(vld1q_f32(in + i + 4), 32768.0f);
+
+    if(dither) {
+      a = vaddq_f32(a, NoiseNeon(state));
+      b = vaddq_f32(b, NoiseNeon(state));
+    }
+
+    a = vminq_f32(high, vmaxq_f32(low, a));
+    b = vminq_f32(high, vmaxq_f32(low, b));
+
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(RoundNeon(a)), vqmovn_s32(RoundNeon(b))));
+  }
+
+  if(dither) vst1q_u32(dither->lanes, state);
+  loftili::audio::ConvertKernels::Scalar().float_to_s16(in + i, out + i, count - i, dither);
+}
+
+void FirNeon(const float* x, const float* c, size_t count, float* out) {
+  float32x4_t a = vdupq_n_f32(0.0f), b = vdupq_n_f32(0.0f);
+
+  for(size_t i = 0; i < count; i += 8) {
+    a = vmlaq_f32(a, vld1q_f32(x + i), vld1q_f32(c + i));
+    b = vmlaq_f32(b, vld1q_f32(x + i + 4), vld1q_f32(c + i + 4));
+  }
+
+  a = vaddq_f32(a, b);
+  vst1_f32(out, vadd_f32(vget_low_f32(a), vget_high_f32(a)));
+}
+
+}
+
+const loftili::audio::ConvertKernels neon_kernels = {
+  "neon", S16ToFloatNeon, S32ToFloatNeon, MonoToStereoNeon, FloatToS16Neon, FirNeon
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "audio/convert_kernels.h"
+
+#if LOFTILI_KERNELS_X86
+
+// the avx2 functions are compiled for avx2 one at a time, leaving the rest of
+// the program built for the baseline; they are only ever called once the
+// processor has said it supports them.
+#define LOFTILI_AVX2 __attribute__((target("avx2")))
+
+namespace loftili {
+
+namespace audio {
+
+namespace {
+
+inline __m128 NoiseSse2(__m128i& x) {
+  const __m128i one = _mm_set1_epi32(0x3f800000);
+  const __m128 half = _mm_set1_ps(1.5f);
+  __m128 sum = _mm_setzero_ps();
+
+  for(int i = 0; i < 2; i++) {
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    sum = _mm_add_ps(sum, _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), one)), half));
+  }
+
+  return sum;
+}
+
+void S16ToFloatSse2(const int16_t* in, float* out, size_t count) {
+  const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*) (in + i));
+    // each sample into the top half of a lane, then shifted down with its sign
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+
+  loftili::audio::ConvertKernels::Scalar().s16_to_float(in + i, out + i, count - i);
+}
+
+void S32ToFloatSse2(const int32_t* in, float* out, size_t count) {
+  const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+  size_t i = 0;
+
+  for(; i + 4 <= count; i += 4)
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*) (in + i))), scale));
+
+  loftili::audio::ConvertKernels::Scalar().s32_to_float(in + i, out + i, count - i);
+}
+
+void MonoToStereoSse2(const float* in, float* out, size_t frames) {
+  size_t i = 0;
+
+  for(; i + 4 <= frames; i += 4) {
+    __m128 v = _mm_loadu_ps(in + i);
+    _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(v, v));
+    _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(v, v));
+  }
+
+  loftili::audio::ConvertKernels::Scalar().mono_to_stereo(in + i, out + i * 2, frames - i);
+}
+
+void FloatToS16Sse2(const float* in, int16_t* out, size_t count, loftili::audio::DitherState* dither) {
+  const __m128 low = _mm_set1_ps(-32768.0f), high = _mm_set1_ps(32767.0f), scale = _mm_set1_ps(32768.0f);
+  __m128i state = dither ? _mm_loadu_si128((const __m128i*) dither->lanes) : _mm_setzero_si128();
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+    __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+
+    if(dither) {
+      a = _mm_add_ps(a, NoiseSse2(state));
+      b = _mm_add_ps(b, NoiseSse2(state));
+    }
+
+    a = _mm_min_ps(high, _mm_max_ps(low, a));
+    b = _mm_min_ps(high, _mm_max_ps(low, b));
+
+    // converts with the current rounding mode, nearest by default, and packs
+    // with saturation
+    _mm_storeu_si128((__m128i*) (out + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+
+  if(dither) _mm_storeu_si128((__m128i*) dither->lanes, state);
+  loftili::audio::ConvertKernels::Scalar().float_to_s16(in + i, out + i, count - i, dither);
+}
+
+void FirSse2(const float* x, const float* c, size_t count, float* out) {
+  __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+
+  for(size_t i = 0; i < count; i += 8) {
+    a = _mm_add_ps(a, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(c + i)));
+    b = _mm_add_ps(b, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(c + i + 4)));
+  }
+
+  // lanes alternate left and right; fold the upper pair onto the lower
+  a = _mm_add_ps(a, b);
+  a = _mm_add_ps(a, _mm_movehl_ps(a, a));
+  out[0] = _mm_cvtss_f32(a);
+  out[1] = _mm_cvtss_f32(_mm_shuffle_ps(a, a, 1));
+}
+
+LOFTILI_AVX2 inline __m256 NoiseAvx2(__m256i& x) {
+  const __m256i one = _mm256_set1_epi32(0x3f800000);
+  const __m256 half = _mm256_set1_ps(1.5f);
+  __m256 sum = _mm256_setzero_ps();
+
+  for(int i = 0; i < 2; i++) {
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+    sum = _mm256_add_ps(sum, _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(x, 9), one)), half));
+  }
+
+  return sum;
+}
+
+LOFTILI_AVX2 void S16ToFloatAvx2(const int16_t* in, float* out, size_t count) {
+  const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+  size_t i = 0;
+
+  for(; i + 16 <= count; i += 16) {
+    __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (in + i)));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) (in + i + 8)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+    _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+  }
+
+  loftili::audio::ConvertKernels::Scalar().s16_to_float(in + i, out + i, count - i);
+}
+
+LOFTILI_AVX2 void S32ToFloatAvx2(const int32_t* in, float* out, size_t count) {
+  const __m256 scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*) (in + i))), scale));
+
+  loftili::audio::ConvertKernels::Scalar().s32_to_float(in + i, out + i, count - i);
+}
+
+LOFTILI_AVX2 void MonoToStereoAvx2(const float* in, float* out, size_t frames) {
+  size_t i = 0;
+
+  for(; i + 8 <= frames; i += 8) {
+    __m256 v = _mm256_loadu_ps(in + i);
+    // unpacking works within each 128 bit half, so the halves are swapped
+    // back into order afterwards
+    __m256 lo = _mm256_unpacklo_ps(v, v), hi = _mm256_unpackhi_ps(v, v);
+    _mm256_storeu_ps(out + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + i * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+
+  loftili::audio::ConvertKernels::Scalar().mono_to_stereo(in + i, out + i * 2, frames - i);
+}
+
+LOFTILI_AVX2 void FloatToS16Avx2(const float* in, int16_t* out, size_t count, loftili::audio::DitherState* dither) {
+  const __m256 low = _mm256_set1_ps(-32768.0f), high = _mm256_set1_ps(32767.0f), scale = _mm256_set1_ps(32768.0f);
+  __m256i state = dither ? _mm256_loadu_si256((const __m256i*) dither->lanes) : _mm256_setzero_si256();
+  size_t i = 0;
+
+  for(; i + 16 <= count; i += 16) {
+    __m256 a = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+    __m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale);
+
+    if(dither) {
+      a = _mm256_add_ps(a, NoiseAvx2(state));
+      b = _mm256_add_ps(b, NoiseAvx2(state));
+    }
+
+    a = _mm256_min_ps(high, _mm256_max_ps(low, a));
+    b = _mm256_min_ps(high, _mm256_max_ps(low, b));
+
+    // packing interleaves the two inputs by 128 bit half; the permute puts
+    // the four quarters back in order
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    _mm256_storeu_si256((__m256i*) (out + i), _mm256_permute4x64_epi64(packed, 0xd8));
+  }
+
+  if(dither) _mm256_storeu_si256((__m256i*) dither->lanes, state);
+  loftili::audio::ConvertKernels::Scalar().float_to_s16(in + i, out + i, count - i, dither);
+}
+
+LOFTILI_AVX2 void FirAvx2(const float* x, const float* c, size_t count, float* out) {
+  __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+  size_t i = 0;
+
+  for(; i + 16 <= count; i += 16) {
+    a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(c + i)));
+    b = _mm256_add_ps(b, _mm256_mul_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(c + i + 8)));
+  }
+
+  if(i < count)
+    a = _mm256_add_ps(a, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(c + i)));
+
+  a = _mm256_add_ps(a, b);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  out[0] = _mm_cvtss_f32(sum);
+  out[1] = _mm_cvtss_f32(_mm_shuffle_ps(sum, sum, 1));
+}
+
+}
+
+const loftili::audio::ConvertKernels sse2_kernels = {
+  "sse2", S16ToFloatSse2, S32ToFloatSse2, MonoToStereoSse2, FloatToS16Sse2, FirSse2
+};
+
+const loftili::audio::ConvertKernels avx2_kernels = {
+  "avx2", S16ToFloatAvx2, S32ToFloatAvx2, MonoToStereoAvx2, FloatToS16Avx2, FirAvx2
+};
+
+}
+
+}
+
+#endif
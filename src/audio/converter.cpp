@@ -0,0 +1,172 @@
+#include "audio/converter.h"
+
+namespace loftili {
+
+namespace audio {
+
+Converter::Converter() : m_kernels(loftili::audio::ConvertKernels::Best()), m_rate(0), m_channels(0), m_encoding(0), m_resampling(false) {
+  m_format.bits = LOFTILI_DEVICE_BITS;
+  m_format.rate = LOFTILI_DEVICE_RATE;
+  m_format.channels = LOFTILI_DEVICE_CHANNELS;
+
+  for(int i = 0; i < 8; i++)
+    m_dither.lanes[i] = 0x9e3779b9u * (i + 1);
+}
+
+// settles how the decoder's format gets to the device's. the resampler's
+// history is kept when the rate is unchanged, so one track runs into the
+// next without a break in the filter.
+bool Converter::Configure(long rate, int channels, int encoding) {
+  if(loftili::audio::sink_configuration.rate > 0)
+    m_format.rate = loftili::audio::sink_configuration.rate;
+
+  bool supported = (channels == 1 || channels == 2)
+    && (encoding == MPG123_ENC_SIGNED_16 || encoding == MPG123_ENC_SIGNED_32 || encoding == MPG123_ENC_FLOAT_32);
+
+  if(!supported) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to convert channels[{0}] encoding[{1}] for the device", channels, encoding);
+    return false;
+  }
+
+  bool resampling = rate != m_format.rate;
+
+  if(resampling && (!m_resampling || rate != m_rate) && !m_resampler.Configure(rate, m_format.rate, m_kernels)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to resample from {0}hz to {1}hz", rate, m_format.rate);
+    return false;
+  }
+
+  m_rate = rate;
+  m_channels = channels;
+  m_encoding = encoding;
+  m_resampling = resampling;
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("converting rate[{0}] channels[{1}] encoding[{2}] to {3}hz with {4} kernels{5}",
+    rate, channels, encoding, m_format.rate, m_kernels.name, resampling ? ", resampling" : "");
+  return true;
+}
+
+// returns the byte count of the converted samples, which are left in a
+// buffer of the converter's own until the next call
+size_t Converter::Convert(const unsigned char* data, size_t size, const unsigned char** out) {
+  if(m_encoding == MPG123_ENC_SIGNED_16 && m_channels == 2 && !m_resampling) {
+    *out = data;
+    return size;
+  }
+
+  size_t width = m_encoding == MPG123_ENC_SIGNED_16 ? 2 : 4;
+  size_t samples = size / width, frames = samples / m_channels;
+  const float* source = (const float*) data;
+
+  if(m_encoding != MPG123_ENC_FLOAT_32) {
+    m_float.resize(samples);
+    source = m_float.data();
+
+    if(m_encoding == MPG123_ENC_SIGNED_16)
+      m_kernels.s16_to_float((const int16_t*) data, m_float.data(), samples);
+    else
+      m_kernels.s32_to_float((const int32_t*) data, m_float.data(), samples);
+  }
+
+  if(m_channels == 1) {
+    m_stereo.resize(frames * 2);
+    m_kernels.mono_to_stereo(source, m_stereo.data(), frames);
+    source = m_stereo.data();
+  }
+
+  return Finish(source, frames, out);
+}
+
+// pushes the resampler's last few frames through, for when nothing follows
+size_t Converter::Flush(const unsigned char** out) {
+  if(!m_resampling) return 0;
+
+  std::vector<float> silence(m_resampler.Taps() * 2, 0.0f);
+  return Finish(silence.data(), m_resampler.Taps(), out);
+}
+
+size_t Converter::Finish(const float* source, size_t frames, const unsigned char** out) {
+  if(m_resampling) {
+    m_resampled.clear();
+    frames = m_resampler.Process(source, frames, m_resampled);
+    source = m_resampled.data();
+  }
+
+  // 16 bit samples that only went through float on their way to being
+  // spread over two channels are scaled by 32768 both ways, so they come
+  // back out exactly and need no dither
+  bool dither = m_resampling || m_encoding != MPG123_ENC_SIGNED_16;
+  m_out.resize(frames * 2);
+  m_kernels.float_to_s16(source, m_out.data(), frames * 2, dither ? &m_dither : NULL);
+
+  *out = (const unsigned char*) m_out.data();
+  return frames * 2 * sizeof(int16_t);
+}
+
+void Converter::Reset() {
+  m_resampler.Reset();
+}
+
+namespace {
+
+// runs a kernel over and over for a while, giving samples per second
+template <class F>
+double Rate(size_t samples, F run) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), now = start;
+  long passes = 0;
+
+  while(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() < LOFTILI_BENCHMARK_MS) {
+    run();
+    passes++;
+    now = std::chrono::steady_clock::now();
+  }
+
+  double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(now - start).count();
+  return samples * passes / seconds;
+}
+
+}
+
+int Converter::Benchmark() {
+  const size_t count = LOFTILI_BENCHMARK_SAMPLES;
+  std::vector<int16_t> s16(count), back(count);
+  std::vector<int32_t> s32(count);
+  std::vector<float> floats(count), stereo(count * 2), resampled;
+  loftili::audio::DitherState dither;
+  const char* names[] = { "s16 to float", "s32 to float", "mono to stereo", "float to s16", "dithered s16", "44.1k to 48k" };
+  std::vector<double> scalar(6);
+
+  for(size_t i = 0; i < count; i++) {
+    s16[i] = (int16_t) (sin(i * 0.01) * 30000);
+    s32[i] = s16[i] << 16;
+    floats[i] = s16[i] / 32768.0f;
+  }
+
+  for(int i = 0; i < 8; i++)
+    dither.lanes[i] = 0x9e3779b9u * (i + 1);
+
+  printf("%-8s %-16s %16s %10s\n", "kernels", "operation", "samples/s", "vs scalar");
+
+  for(auto kernels : loftili::audio::ConvertKernels::Available()) {
+    loftili::audio::Resampler resampler;
+    resampler.Configure(44100, 48000, *kernels);
+    double rates[6];
+
+    rates[0] = Rate(count, [&] { kernels->s16_to_float(s16.data(), floats.data(), count); });
+    rates[1] = Rate(count, [&] { kernels->s32_to_float(s32.data(), floats.data(), count); });
+    rates[2] = Rate(count, [&] { kernels->mono_to_stereo(floats.data(), stereo.data(), count); });
+    rates[3] = Rate(count, [&] { kernels->float_to_s16(floats.data(), back.data(), count, NULL); });
+    rates[4] = Rate(count, [&] { kernels->float_to_s16(floats.data(), back.data(), count, &dither); });
+    rates[5] = Rate(count, [&] { resampled.clear(); resampler.Process(stereo.data(), count / 2, resampled); });
+
+    for(int i = 0; i < 6; i++) {
+      if(kernels == &loftili::audio::ConvertKernels::Scalar()) scalar[i] = rates[i];
+      printf("%-8s %-16s %16.0f %9.2fx\n", kernels->name, names[i], rates[i], rates[i] / scalar[i]);
+    }
+  }
+
+  return 0;
+}
+
+}
+
+}
@@ -0,0 +1,122 @@
+#include "audio/feed_buffer.h"
+
+namespace loftili {
+
+namespace audio {
+
+FeedBuffer::~FeedBuffer() {
+  if(m_spill != NULL) fclose(m_spill);
+}
+
+// never blocks. bytes only go to memory while nothing is waiting in the spill
+// file, so the decoder always reads them back in the order they arrived.
+bool FeedBuffer::Write(const char* data, size_t size) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(m_abandoned) return false;
+
+  if(m_spilled > m_unspilled || m_data.size() - m_offset >= LOFTILI_FEED_BUFFER_BYTES) {
+    if(!Spill(data, size)) return false;
+    m_ready.notify_all();
+    return true;
+  }
+
+  // consumed bytes are dropped once they make up most of the buffer, so a
+  // track never sits in memory much longer than it takes to decode it.
+  if(m_offset > 0 && m_offset >= m_data.size() / 2) {
+    m_data.erase(m_data.begin(), m_data.begin() + m_offset);
+    m_offset = 0;
+  }
+
+  m_data.insert(m_data.end(), data, data + size);
+  m_ready.notify_all();
+  return true;
+}
+
+// the spill file is made the first time memory fills up and goes away with
+// the buffer.
+bool FeedBuffer::Spill(const char* data, size_t size) {
+  if(m_spill == NULL && (m_spill = tmpfile()) == NULL)
+    return false;
+
+  if(fseek(m_spill, m_spilled, SEEK_SET) != 0 || fwrite(data, 1, size, m_spill) != size)
+    return false;
+
+  m_spilled += size;
+  return true;
+}
+
+// once all of it has been read back the file is started over, and the
+// writer goes back to memory.
+size_t FeedBuffer::Unspill(unsigned char* out, size_t max) {
+  size_t count = std::min(max, m_spilled - m_unspilled);
+
+  if(fflush(m_spill) != 0 || fseek(m_spill, m_unspilled, SEEK_SET) != 0)
+    return 0;
+
+  count = fread(out, 1, count, m_spill);
+  m_unspilled += count;
+
+  if(m_unspilled == m_spilled)
+    m_spilled = m_unspilled = 0;
+
+  return count;
+}
+
+void FeedBuffer::Finish(bool ok) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_finished = true;
+  m_ok = ok;
+  m_ready.notify_all();
+}
+
+void FeedBuffer::Abandon() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_abandoned = true;
+  m_ready.notify_all();
+}
+
+// blocks until at least amount bytes are waiting or no more will come
+size_t FeedBuffer::Wait(size_t amount) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_ready.wait(lock, [this, amount] {
+    return m_finished || m_abandoned || Waiting() >= amount;
+  });
+  return Waiting();
+}
+
+// 0 only once the writer has finished and everything it wrote was read, or
+// the spill file could not be read back
+size_t FeedBuffer::Read(unsigned char* out, size_t max) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_ready.wait(lock, [this] {
+    return m_finished || m_abandoned || Waiting() > 0;
+  });
+
+  if(m_data.size() == m_offset)
+    return m_spilled > m_unspilled ? Unspill(out, max) : 0;
+
+  size_t count = std::min(max, m_data.size() - m_offset);
+  memcpy(out, &m_data[m_offset], count);
+  m_offset += count;
+  return count;
+}
+
+size_t FeedBuffer::Buffered() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return Waiting();
+}
+
+bool FeedBuffer::Finished() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return m_finished;
+}
+
+bool FeedBuffer::Ok() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  return m_finished && m_ok;
+}
+
+}
+
+}
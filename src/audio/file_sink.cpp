@@ -0,0 +1,41 @@
+#include "audio/file_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+FileSink::~FileSink() {
+  Close();
+}
+
+bool FileSink::Open(const loftili::audio::AudioFormat& format) {
+  if((m_handle = open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to open {0} for audio output: {1}", m_path, strerror(errno));
+    return false;
+  }
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("writing {0} bit {1}hz {2} channel audio to {3}", format.bits, format.rate, format.channels, m_path);
+  return true;
+}
+
+void FileSink::Close() {
+  if(m_handle < 0) return;
+  close(m_handle);
+  m_handle = -1;
+}
+
+bool FileSink::Play(const unsigned char* data, size_t size) {
+  while(size > 0) {
+    ssize_t written = write(m_handle, data, size);
+    if(written < 0 && errno == EINTR) continue;
+    if(written <= 0) return false;
+    data += written;
+    size -= written;
+  }
+
+  return true;
+}
+
+}
+
+}
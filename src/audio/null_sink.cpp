@@ -0,0 +1,30 @@
+#include "audio/null_sink.h"
+
+namespace loftili {
+
+namespace audio {
+
+bool NullSink::Open(const loftili::audio::AudioFormat& format) {
+  m_rate = (long) format.rate * format.channels * format.bits / 8;
+  m_clock = std::chrono::steady_clock::now();
+  return m_rate > 0;
+}
+
+// keeps to a running clock rather than sleeping each write off on its own, so
+// time spent outside Play doesn't add up; after a long pause the clock starts
+// over instead of rushing to catch up.
+bool NullSink::Play(const unsigned char*, size_t size) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  if(m_clock < now - std::chrono::seconds(1))
+    m_clock = now;
+
+  m_clock += std::chrono::microseconds((long long) size * 1000000 / m_rate);
+  m_delay = std::chrono::duration_cast<std::chrono::milliseconds>(m_clock - now).count();
+  std::this_thread::sleep_until(m_clock);
+  return true;
+}
+
+}
+
+}
@@ -0,0 +1,241 @@
+#include "audio/output.h"
+
+namespace loftili {
+
+namespace audio {
+
+Output::Output() : m_ring(LOFTILI_OUTPUT_RING_BYTES), m_open(false), m_frame(1),
+  m_running(false), m_draining(false), m_drained(false), m_idle(false), m_target(0), m_underruns(0), m_boundary(LOFTILI_OUTPUT_NO_BOUNDARY),
+  m_gap(-1), m_played(0), m_dry(false), m_dry_delay(0), m_target_ms(LOFTILI_OUTPUT_TARGET_START_MS), m_seen_underruns(0),
+  m_written(0), m_low(SIZE_MAX) {
+}
+
+Output::~Output() {
+  Close();
+}
+
+// keeps the sink open when the format is unchanged; otherwise whatever is
+// still queued is played out in the old format before the sink is reopened.
+bool Output::Open(const loftili::audio::AudioFormat& format) {
+  if(m_open && m_format.bits == format.bits && m_format.rate == format.rate && m_format.channels == format.channels)
+    return true;
+
+  Drain();
+  Close();
+
+  if(!m_sink)
+    m_sink.reset(loftili::audio::AudioSink::Create(loftili::audio::sink_configuration));
+
+  m_format = format;
+
+  if(!(m_open = m_sink->Open(m_format))) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("failed opening {0} audio output, unable to play audio", m_sink->Name());
+    return false;
+  }
+
+  m_frame = m_format.channels * m_format.bits / 8;
+  m_target = Bytes(m_target_ms);
+  m_low = SIZE_MAX;
+  m_window = std::chrono::steady_clock::now();
+  m_running = true;
+  m_thread = std::thread(&Output::Run, this);
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("[AUDIO PLAYBACK STARTING] opened {0} audio output, target fill {1}ms", m_sink->Name(), m_target_ms);
+  return true;
+}
+
+// queues samples for the output thread, waiting for room while the ring is
+// full. false if the output was closed before all of them fit.
+bool Output::Write(const unsigned char* data, size_t size) {
+  if(!m_open) return false;
+
+  m_idle = false;
+  Adapt(m_ring.Available());
+
+  while(size > 0 && m_running) {
+    size_t written = m_ring.Write(data, size);
+    m_written += written;
+    data += written;
+    size -= written;
+
+    if(size > 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOFTILI_OUTPUT_POLL_MS));
+  }
+
+  return size == 0;
+}
+
+// lets everything queued be played, ignoring the target on the way out, and
+// waits for the output thread to drain the sink as well. the sink then sits
+// idle until more is written, which is not an underrun.
+void Output::Drain() {
+  if(!m_open) return;
+
+  m_drained = false;
+  m_draining = true;
+
+  while(m_running && !m_drained)
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOFTILI_OUTPUT_POLL_MS));
+
+  m_idle = true;
+  m_draining = false;
+}
+
+// called before the first samples of a track that follows straight on from
+// the last one are written
+void Output::Mark() {
+  if(m_open) m_boundary.store(m_written, std::memory_order_release);
+}
+
+// stops the output thread and drops anything it had not played yet
+void Output::Close() {
+  m_running = false;
+
+  if(m_thread.joinable())
+    m_thread.join();
+
+  m_played = m_written;
+  m_boundary = LOFTILI_OUTPUT_NO_BOUNDARY;
+
+  if(m_open) {
+    m_sink->Close();
+    m_open = false;
+  }
+
+  m_ring.Reset();
+  loftili::lib::metrics.Set("audio.output.underruns", m_underruns);
+}
+
+void Output::Run() {
+  bool buffering = true;
+
+  while(m_running.load(std::memory_order_acquire)) {
+    size_t available = m_ring.Available();
+    bool draining = m_draining.load(std::memory_order_acquire) || m_idle.load(std::memory_order_acquire);
+
+    if(buffering && available < m_target.load(std::memory_order_relaxed) && !draining) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOFTILI_OUTPUT_POLL_MS));
+      continue;
+    }
+
+    buffering = false;
+    size_t count = std::min(available, (size_t) LOFTILI_OUTPUT_CHUNK_BYTES);
+    count -= count % m_frame;
+
+    if(count == 0) {
+      if(!draining) m_underruns.fetch_add(1, std::memory_order_relaxed);
+      buffering = true;
+      m_sink->Idle();
+
+      if(!m_dry) {
+        m_dry = true;
+        m_dry_delay = m_sink->Delay();
+        m_dry_since = std::chrono::steady_clock::now();
+      }
+
+      if(m_draining.load(std::memory_order_acquire) && !m_drained.load(std::memory_order_acquire)) {
+        m_sink->Drain();
+        m_drained.store(true, std::memory_order_release);
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOFTILI_OUTPUT_POLL_MS));
+      continue;
+    }
+
+    // the sink may hand out less room than asked for, or none while it waits
+    // on the device; whatever is left stays in the ring for the next pass.
+    unsigned char* room = m_sink->Begin(count);
+    if(room == NULL || count == 0) continue;
+
+    m_ring.Read(room, count);
+    m_sink->Commit(count);
+    Crossed(count);
+  }
+}
+
+// output thread only. a track's first samples either went out in the same
+// pass as the last one's, or after the device had been left to run dry.
+void Output::Crossed(size_t count) {
+  uint64_t boundary = m_boundary.load(std::memory_order_acquire);
+  uint64_t from = m_played;
+  m_played += count;
+
+  if(boundary != LOFTILI_OUTPUT_NO_BOUNDARY && from <= boundary && boundary < m_played) {
+    long gap = 0;
+
+    if(from == boundary && m_dry) {
+      long stalled = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_dry_since).count();
+      gap = std::max(0L, stalled - m_dry_delay);
+    }
+
+    m_boundary.compare_exchange_strong(boundary, LOFTILI_OUTPUT_NO_BOUNDARY, std::memory_order_acq_rel);
+    m_gap.store(gap, std::memory_order_release);
+  }
+
+  m_dry = false;
+}
+
+// runs on the decoder's side with the fill level it found before writing
+void Output::Adapt(size_t level) {
+  m_low = std::min(m_low, level);
+  long gap = m_gap.exchange(-1, std::memory_order_acq_rel);
+
+  if(gap >= 0) {
+    loftili::lib::metrics.Set("audio.gap_ms", gap);
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("{0}ms of silence between the last track's final sample and this one's first", gap);
+  }
+
+  loftili::lib::metrics.Set("audio.output.delay_ms", m_sink->Delay());
+  loftili::lib::metrics.Set("audio.output.xruns", m_sink->Xruns());
+  long underruns = m_underruns.load(std::memory_order_relaxed);
+
+  if(underruns != m_seen_underruns) {
+    m_seen_underruns = underruns;
+    loftili::lib::metrics.Set("audio.output.underruns", underruns);
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("audio output ran dry, [{0}] underruns so far", underruns);
+    Retarget(m_target_ms * 3 / 2);
+    return;
+  }
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  if(std::chrono::duration_cast<std::chrono::milliseconds>(now - m_window).count() < LOFTILI_OUTPUT_WINDOW_MS)
+    return;
+
+  long low = Milliseconds(m_low);
+  loftili::lib::metrics.Set("audio.output.low_ms", low);
+
+  if(low < m_target_ms / 4)
+    Retarget(m_target_ms * 3 / 2);
+  else if(low > m_target_ms * 3 / 4)
+    Retarget(m_target_ms * 9 / 10);
+
+  m_low = SIZE_MAX;
+  m_window = now;
+}
+
+void Output::Retarget(long target) {
+  long ceiling = Milliseconds(m_ring.Capacity() * 3 / 4);
+  target = std::max((long) LOFTILI_OUTPUT_TARGET_MIN_MS, std::min(target, ceiling));
+
+  if(target != m_target_ms)
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("audio output target fill now {0}ms", target);
+
+  m_target_ms = target;
+  m_target = Bytes(target);
+  m_low = SIZE_MAX;
+  m_window = std::chrono::steady_clock::now();
+  loftili::lib::metrics.Set("audio.output.target_ms", target);
+}
+
+long Output::Milliseconds(size_t bytes) {
+  return (long) (bytes / m_frame * 1000 / m_format.rate);
+}
+
+size_t Output::Bytes(long milliseconds) {
+  return (size_t) milliseconds * m_format.rate / 1000 * m_frame;
+}
+
+}
+
+}
@@ -0,0 +1,55 @@
+#include "audio/pcm_ring.h"
+
+namespace loftili {
+
+namespace audio {
+
+PcmRing::PcmRing(size_t capacity) : m_head(0), m_tail(0) {
+  size_t size = 1;
+  while(size < capacity) size <<= 1;
+  m_data.resize(size);
+  m_mask = size - 1;
+}
+
+// writer side only; copies what fits and says how much that was
+size_t PcmRing::Write(const unsigned char* data, size_t size) {
+  size_t head = m_head.load(std::memory_order_relaxed);
+  size_t tail = m_tail.load(std::memory_order_acquire);
+  size_t count = std::min(size, m_data.size() - (head - tail));
+  size_t start = head & m_mask;
+  size_t first = std::min(count, m_data.size() - start);
+
+  memcpy(&m_data[start], data, first);
+  memcpy(&m_data[0], data + first, count - first);
+  m_head.store(head + count, std::memory_order_release);
+  return count;
+}
+
+// reader side only
+size_t PcmRing::Read(unsigned char* out, size_t size) {
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t head = m_head.load(std::memory_order_acquire);
+  size_t count = std::min(size, head - tail);
+  size_t start = tail & m_mask;
+  size_t first = std::min(count, m_data.size() - start);
+
+  memcpy(out, &m_data[start], first);
+  memcpy(out + first, &m_data[0], count - first);
+  m_tail.store(tail + count, std::memory_order_release);
+  return count;
+}
+
+size_t PcmRing::Available() const {
+  size_t tail = m_tail.load(std::memory_order_acquire);
+  return m_head.load(std::memory_order_acquire) - tail;
+}
+
+// only while neither side is running
+void PcmRing::Reset() {
+  m_head.store(0);
+  m_tail.store(0);
+}
+
+}
+
+}
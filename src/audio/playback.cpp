@@ -4,66 +4,110 @@ namespace loftili {
 
 namespace audio {
 
+Playback::~Playback() {
+  std::unique_lock<std::mutex> mutex_lock(m_mutex);
+  m_closing = true;
+  m_wanted = false;
+  m_player.Stop();
+  m_wake.notify_all();
+  mutex_lock.unlock();
+
+  if(m_thread.joinable())
+    m_thread.join();
+}
+
 void Playback::Start() {
   std::unique_lock<std::mutex> mutex_lock(m_mutex);
 
-  if(m_state == PLAYBACK_STATE_PLAYING) {
+  if(m_wanted) {
     spdlog::get(LOFTILI_SPDLOG_ID)->info("playback already started, skipping request");
-    mutex_lock.unlock();
     return;
   }
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback about to open thread, joining if existing");
-
-  if(m_thread.joinable()) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("playback joinable, finish first");
-    m_thread.join();
-  }
-
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback starting, updating state on api and opening playback thread");
-  m_state = PLAYBACK_STATE_PLAYING;
-  m_stateclient.Update("playback", 1);
-  m_thread = std::thread(&Playback::Run, this);
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback thread opened successfully.");
-  mutex_lock.unlock();
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback starting, waking playback thread");
+  m_wanted = true;
+  Wake();
 }
 
+// the playing track is stopped and playback goes round again from the head
+// of the queue; nothing here waits for the old track to wind down.
 void Playback::Skip() {
+  std::unique_lock<std::mutex> mutex_lock(m_mutex);
   spdlog::get(LOFTILI_SPDLOG_ID)->info("playback received skip request, current state [{0}]", m_state);
 
   if(m_state == PLAYBACK_STATE_PLAYING) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("skip request stopping playback before continuing");
-    Stop();
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("skip request stopping player before continuing");
+    m_restart = true;
+    m_player.Stop();
   }
 
-  Start();
+  m_wanted = true;
+  Wake();
 }
 
 void Playback::Stop() {
   std::unique_lock<std::mutex> mutex_lock(m_mutex);
 
-  if(m_state == PLAYBACK_STATE_STOPPED) {
+  if(!m_wanted) {
     spdlog::get(LOFTILI_SPDLOG_ID)->info("playback alread stopped, ignoring request to stop");
-    mutex_lock.unlock();
     return;
   }
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("stopping player and playback run thread");
-  m_state = PLAYBACK_STATE_STOPPED;
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("stopping player, playback thread will wind down");
+  m_wanted = false;
+  m_restart = false;
   m_player.Stop();
-  m_thread.join();
-  mutex_lock.unlock();
+}
+
+// called with the lock held.
+void Playback::Wake() {
+  if(m_closing) return;
+
+  if(!m_thread.joinable()) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("opening playback thread");
+    m_thread = std::thread(&Playback::Run, this);
+  }
+
+  m_wake.notify_all();
 }
 
 void Playback::Run() {
-  m_state = PLAYBACK_STATE_PLAYING;
+  std::unique_lock<std::mutex> mutex_lock(m_mutex);
+
+  while(true) {
+    m_wake.wait(mutex_lock, [this] { return m_closing || m_wanted; });
+
+    if(m_closing) break;
+
+    m_restart = false;
+    m_state = PLAYBACK_STATE_PLAYING;
+    mutex_lock.unlock();
+    Play();
+    mutex_lock.lock();
+    m_state = PLAYBACK_STATE_STOPPED;
+
+    // an empty queue or a failed track ends playback until the next start;
+    // only a skip sends us straight round again.
+    if(!m_restart) m_wanted = false;
+  }
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback thread finishing");
+}
+
+bool Playback::Continuing() {
+  std::lock_guard<std::mutex> mutex_lock(m_mutex);
+  return m_wanted && !m_restart && !m_closing;
+}
+
+void Playback::Play() {
+  m_stateclient.Update("playback", 1);
 
-  while(m_queue >> m_player && m_state == PLAYBACK_STATE_PLAYING) { 
+  while(Continuing() && m_queue >> m_player) {
     spdlog::get(LOFTILI_SPDLOG_ID)->info("player finished, getting next track from queue");
   }
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback run thread finishing");
-  m_state = PLAYBACK_STATE_STOPPED;
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("playback run finishing");
+  m_player.Release();
   m_stateclient.Update("playback", 0);
   m_stateclient.Update("current_track", 0);
 }
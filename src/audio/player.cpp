@@ -4,149 +4,244 @@ namespace loftili {
 
 namespace audio {
 
-void Player::Stop() {
-  m_state = PLAYER_STATE_STOPPED;
+Player::~Player() {
+  Shutdown();
 }
 
-bool Player::Exists(std::string filename) {
-  std::ifstream infile(filename);
-  return infile.good();
+void Player::Stop() {
+  m_state = PLAYER_STATE_STOPPED;
 }
 
-bool Player::Play() {
-  std::string url = StreamUrl();
+// plays the head of the queue, decoding it while it downloads. once all of it
+// has arrived, advance names the track after it, if there is one, and that
+// one starts downloading and priming behind this one. by the time this
+// track runs out the next is ready, and whatever its format, its samples are
+// converted to the device's and queued straight after this one's last.
+bool Player::Play(int id, loftili::audio::PlayerAdvance advance) {
   m_state = PLAYER_STATE_PLAYING;
-  Startup();
-  loftili::net::HttpClient client;
-  loftili::net::HttpRequest req(loftili::net::Url(url.c_str()));
-  req.Header(LOFTILI_API_TOKEN_HEADER, loftili::api::credentials.token);
-  req.Header(LOFTILI_API_SERIAL_HEADER, loftili::api::configuration.serial);
-  mpg123_handle* m_handle;
-  m_handle = mpg123_new(NULL, NULL);
-
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("opening http request to streaming url [{0}]", url.c_str());
+  std::chrono::steady_clock::time_point requested = std::chrono::steady_clock::now();
+  std::unique_ptr<loftili::audio::Track> track(std::move(m_next));
+
+  // a prefetch that failed before telling us anything is worth one more try,
+  // this time from the stream of the queue it now heads
+  if(track && track->Failed() && !track->Primed()) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("prefetched track failed with status[{0}], requesting it again", track->Status());
+    Reclaim(track);
+  }
 
-  if(!client.Send(req)) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("download {0} failed completely", url.c_str());
-    return false;
+  if(track && track->Id() != id) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("prefetched track[{0}] is no longer the head, dropping it", track->Id());
+    Reclaim(track);
   }
 
-  std::shared_ptr<loftili::net::HttpResponse> res = client.Latest();
-  if(res->Status() != 200) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("download {0} failed with status[{0}]", res->Status());
+  if(track)
+    loftili::lib::metrics.Increment("audio.prefetch.used");
+  else
+    track.reset(Fetch(id, true));
+
+  if(!track) {
+    Release();
+    m_state = PLAYER_STATE_STOPPED;
     return false;
   }
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("request finished with status[{0}]", res->Status());
+  bool decoded = track->Prime(true) && Configure(*track);
+  bool advanced = false, heard = false;
+  size_t buffer_size = track->OutBlock();
+  std::vector<unsigned char> buffer(buffer_size);
 
-  std::size_t last_slash = url.find_last_of("/");
-  std::string filename = url.substr(last_slash + 1);
-  filename += ".mp3";
+  while(decoded && m_state == PLAYER_STATE_PLAYING) {
+    size_t done = 0;
+    int err = track->Read(buffer.data(), buffer_size, &done);
 
-  if(Exists(filename)) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("file with same name exists, removing");
-    remove(filename.c_str());
-  }
+    if(err == MPG123_NEW_FORMAT) {
+      decoded = Configure(*track);
+      continue;
+    }
 
-  if(m_state != PLAYER_STATE_PLAYING) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("playback stopped before track finished downloading, exiting");
-    Shutdown();
-    return false;
-  }
+    if(done > 0) {
+      if(!heard) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        long waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - requested).count();
+        loftili::lib::metrics.Set("audio.first_audio_ms", waited);
+        spdlog::get(LOFTILI_SPDLOG_ID)->info("first audio from [{0}] after {1}ms", track->Url().c_str(), waited);
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("download complete, temporarily saving to file system [{0}]", filename.c_str());
-  std::ofstream download;
-  download.open(filename.c_str(), std::ios::binary | std::ios::out);
-  download.write(res->Body(), res->ContentLength());
-  download.close();
-  int err = mpg123_open(m_handle, filename.c_str());
-
-  if(err != MPG123_OK) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to open mpg123 handle on downloaded track");
-    mpg123_close(m_handle);
-    mpg123_delete(m_handle);
-    Shutdown();
-    m_state = PLAYER_STATE_STOPPED;
-    return false;
-  }
+        // the output times the silence between the two tracks as it plays them
+        if(m_continuing) m_output.Mark();
+        heard = true;
+      }
 
-  off_t frame_offset;
-  unsigned char* audio;
-  size_t done;
-  int channels, encoding;
-  long rate;
+      const unsigned char* converted = NULL;
+      size_t size = m_converter.Convert(buffer.data(), done, &converted);
+      if(size > 0 && !m_output.Write(converted, size)) decoded = false;
+    }
 
-  err = mpg123_getformat(m_handle, &rate, &channels, &encoding);
+    int next = !advanced && advance && track->Downloaded() ? advance() : LOFTILI_PLAYER_ADVANCE_PENDING;
 
-  if(err != MPG123_OK) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("invalid mpg123 format detected [{0}]", filename.c_str());
-    m_state = PLAYER_STATE_STOPPED;
-    mpg123_close(m_handle);
-    mpg123_delete(m_handle);
-    Shutdown();
-    return false;
+    if(next != LOFTILI_PLAYER_ADVANCE_PENDING) {
+      advanced = true;
+
+      if(next >= 0) {
+        spdlog::get(LOFTILI_SPDLOG_ID)->info("track downloaded, prefetching track[{0}]", next);
+        m_next.reset(Fetch(next, false));
+      }
+    }
+
+    if(m_next && !m_next->Primed())
+      m_next->Prime(false);
+
+    if(err == MPG123_OK) continue;
+    if(err == MPG123_DONE) break;
+
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("mpg123 failed decoding [{0}]: {1}", track->Url().c_str(), mpg123_plain_strerror(err));
+    decoded = false;
   }
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("mpg123 format checks out rate[{0}] channels[{1}] encoding[{2}]", rate, channels, encoding);
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("[AUDIO PLAYBACK STOPPED] audio player loop finished with state [{0}]", m_state);
 
-  ao_sample_format format;
-  format.bits = mpg123_encsize(encoding) * 8;
-  format.rate = rate;
-  format.channels = channels;
-  format.byte_format = AO_FMT_NATIVE;
-  format.matrix = 0;
+  bool played = m_state == PLAYER_STATE_PLAYING && decoded && track->Downloaded();
+
+  if(m_state != PLAYER_STATE_PLAYING)
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("playback stopped before track finished, exiting");
+  else if(track->TimedOut())
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("download {0} timed out", track->Url().c_str());
+  else if(track->Failed() && track->Status() > 0)
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("download {0} failed with status[{1}]", track->Url().c_str(), track->Status());
+  else if(track->Failed())
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("download {0} failed completely", track->Url().c_str());
+
+  // the device stays open for whatever plays next; with nothing lined up, the
+  // audio still queued for it is let play out so the next track starts clean.
+  Reclaim(track);
+  m_continuing = played;
+  if(played && !m_next) Finish();
+  if(!played) Release();
+
+  return played;
+}
 
-  int driver_id = ao_default_driver_id();
-  ao_device* dev = ao_open_live(driver_id, &format, NULL);
+// plays from the cache when it has the track, downloads it otherwise. the
+// head of the queue comes from the queue's own stream, and a track further
+// down is asked for by its id.
+loftili::audio::Track* Player::Fetch(int id, bool head) {
+  std::unique_ptr<loftili::audio::Track> track(new loftili::audio::Track());
+  std::string path, url = StreamUrl(head ? -1 : id);
+  mpg123_handle* handle = Handle();
+  bool opened;
+
+  m_cache.Open();
+
+  if(m_cache.Find(id, path)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("playing track[{0}] from cached file [{1}]", id, path.c_str());
+    opened = track->Load(path, id, handle);
+  } else {
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("opening http request to streaming url [{0}], decoding as it arrives", url.c_str());
+    opened = track->Open(url, id, &m_cache, handle);
+  }
 
-  if(dev == NULL) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->critical("failed opening libao device, unable to play audio");
-    mpg123_close(m_handle);
-    mpg123_delete(m_handle);
-    Shutdown();
-    return false;
+  if(!opened) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("unable to open mpg123 handle for track[{0}]", id);
+    Reclaim(track);
+    return NULL;
   }
 
-  size_t buffer_size = mpg123_outblock(m_handle);
-  unsigned char *buffer = (unsigned char*) malloc(buffer_size * sizeof(unsigned char));
+  return track.release();
+}
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("[AUDIO PLAYBACK STARTING] opened audio driver[{0}], opening loop", driver_id); 
+// decoder handles are made once and passed from track to track. the decoder
+// is left to produce each track at its own rate, in whichever of the sample
+// formats the converter takes it prefers.
+mpg123_handle* Player::Handle() {
+  Startup();
+  mpg123_handle* handle = NULL;
+
+  if(m_handles.size() > 0) {
+    handle = m_handles.back();
+    m_handles.pop_back();
+  } else if((handle = mpg123_new(NULL, NULL)) != NULL) {
+    // gapless decoding drops the encoder delay and padding recorded in the
+    // lame header, so the last sample of one track can sit right against the
+    // first of the next.
+    mpg123_param(handle, MPG123_ADD_FLAGS, MPG123_GAPLESS, 0);
+  } else {
+    return NULL;
+  }
 
-  while(mpg123_read(m_handle, buffer, buffer_size, &done) == MPG123_OK && m_state == PLAYER_STATE_PLAYING)
-    ao_play(dev, (char*)buffer, done);
+  const long* rates = NULL;
+  size_t count = 0;
+  mpg123_rates(&rates, &count);
+  mpg123_format_none(handle);
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("[AUDIO PLAYBACK STOPPED] audio player loop finished with state [{0}]", m_state);
+  for(size_t i = 0; i < count; i++)
+    mpg123_format(handle, rates[i], MPG123_MONO | MPG123_STEREO, MPG123_ENC_SIGNED_16 | MPG123_ENC_SIGNED_32 | MPG123_ENC_FLOAT_32);
 
-  free(buffer);
-  ao_close(dev);
-  mpg123_close(m_handle);
-  mpg123_delete(m_handle);
-  Shutdown();
+  return handle;
+}
 
-  remove(filename.c_str());
+void Player::Reclaim(std::unique_ptr<loftili::audio::Track>& track) {
+  if(!track) return;
 
-  return m_state == PLAYER_STATE_PLAYING;
+  mpg123_handle* handle = track->Release();
+  if(handle != NULL) m_handles.push_back(handle);
+  track.reset();
+}
+
+// every track is converted to the same device format, so the output only
+// opens its device the first time and keeps it from then on.
+bool Player::Configure(loftili::audio::Track& track) {
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("mpg123 format checks out rate[{0}] channels[{1}] encoding[{2}]", track.rate, track.channels, track.encoding);
+  return m_converter.Configure(track.rate, track.channels, track.encoding) && m_output.Open(m_converter.Format());
+}
+
+// lets the last of the converted audio through and plays out the queue
+void Player::Finish() {
+  const unsigned char* converted = NULL;
+  size_t size = m_converter.Flush(&converted);
+  if(size > 0) m_output.Write(converted, size);
+  m_converter.Reset();
+  m_output.Drain();
+}
+
+// drops any prefetch and closes the device; the libraries and decoder
+// handles are kept for whenever playback starts again.
+void Player::Release() {
+  Reclaim(m_next);
+  m_converter.Reset();
+  m_output.Close();
 }
 
 Player::operator bool() {
   return m_state == PLAYER_STATE_PLAYING;
 }
 
+// libao scans its plugins and mpg123 builds its tables here, so both are
+// only done the first time anything is played and undone on the way out.
 void Player::Startup() {
+  if(m_running) return;
   ao_initialize();
   mpg123_init();
+  m_running = true;
 }
 
 void Player::Shutdown() {
+  if(!m_running) return;
+  Release();
+
+  for(auto handle : m_handles)
+    mpg123_delete(handle);
+
+  m_handles.clear();
   ao_shutdown();
   mpg123_exit();
+  m_running = false;
 }
 
-std::string Player::StreamUrl() {
+std::string Player::StreamUrl(int id) {
   std::stringstream ss;
   ss << loftili::api::configuration.protocol << "://";
   ss << loftili::api::configuration.hostname << ":" << loftili::api::configuration.port << "/queues/";
   ss << loftili::api::credentials.device_id << "/stream";
+  if(id >= 0) ss << "/" << id;
   return ss.str();
 }
 
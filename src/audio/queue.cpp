@@ -10,67 +10,143 @@ void Queue::Pop() {
   std::string popurl = QueueUrl();
   popurl.append("/pop");
   loftili::net::HttpRequest req(loftili::net::Url(popurl.c_str()), "POST");
-  req.Header(LOFTILI_API_TOKEN_HEADER, loftili::api::credentials.token);
-  req.Header(LOFTILI_API_SERIAL_HEADER, loftili::api::configuration.serial);
+  req.Header(loftili::api::DeviceHeaders());
   client.Send(req);
+  // whatever we knew as the head has just been played
+  m_stale = true;
   spdlog::get(LOFTILI_SPDLOG_ID)->info("pop request finished");
   return;
 };
 
 bool Queue::operator>>(loftili::audio::Player& player) {
+  int current_id = Head();
+
+  if(current_id < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue appears to be empty, even after loading in new version");
+    return false;
+  }
+
+  m_stateclient.Update("current_track", current_id);
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("updated current_track device state to id[{0}]", current_id);
+
+  // the track after this one is fetched ahead by its id once this one has
+  // downloaded; the listing is checked again first in case the queue changed
+  // while it played. that check runs on the reactor and the player picks up
+  // its answer whenever it lands. the queue itself only moves once this
+  // track is done.
+  std::shared_ptr<Lookahead> ahead;
+  bool played = player.Play(current_id, [this, current_id, &ahead] {
+    if(!ahead) ahead = Lookup(current_id);
+    return ahead->ready ? ahead->next.load() : LOFTILI_PLAYER_ADVANCE_PENDING;
+  });
+
+  if(!played)
+    return false;
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("player appeared to finish the track");
+  Pop();
+  return true;
+}
+
+// asks the api for the queue only if it changed since our copy, and reads no
+// further into it than the ids of the head and the track after it.
+int Queue::Head() {
   loftili::net::HttpClient client;
   loftili::net::HttpRequest req(loftili::net::Url(QueueUrl().c_str()));
-  req.Header(LOFTILI_API_TOKEN_HEADER, loftili::api::credentials.token);
-  req.Header(LOFTILI_API_SERIAL_HEADER, loftili::api::configuration.serial);
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("retreiving track queue from {0}", QueueUrl().c_str());
+  req.Header(loftili::api::DeviceHeaders());
 
-  if(client.Send(req)) {
-    std::shared_ptr<loftili::net::HttpResponse> res = client.Latest();
+  if(m_head >= 0 && m_etag.size() > 0)
+    req.Header("If-None-Match", m_etag);
 
-    if(res->Status() != 200) {
-      spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue request received bad status code from api");
-      return false;
-    }
+  if(m_head >= 0 && m_modified.size() > 0)
+    req.Header("If-Modified-Since", m_modified);
 
-    rapidjson::Document document;
-    document.Parse(res->Body());
-    const rapidjson::Value& a = document["queue"];
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("retreiving track queue from {0}", QueueUrl().c_str());
 
-    if(!a.IsArray()) {
-      spdlog::get(LOFTILI_SPDLOG_ID)->warn("received invalid data format from api, queue did not appear as an array");
-      return false;
+  if(!client.Send(req) || client.Latest()->Status() >= 500) {
+    if(m_head >= 0 && !m_stale) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue request failed, continuing with cached head id[{0}]", m_head);
+      return m_head;
     }
 
-    int queue_length = 0;
-    int current_id = -1;
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue request failed with nothing usable cached");
+    return -1;
+  }
 
-    for(rapidjson::SizeType i = 0; i < a.Size(); i++) {
-      queue_length++;
-      const rapidjson::Value& track = a[i];
+  std::shared_ptr<loftili::net::HttpResponse> res = client.Latest();
 
-      if(!track["id"].IsInt())
-        continue;
+  if(res->Status() == 304 && m_head >= 0) {
+    loftili::lib::metrics.Increment("api.queue.not_modified");
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("queue unchanged, reusing head id[{0}]", m_head);
+    m_stale = false;
+    return m_head;
+  }
 
-      if(current_id < 0)
-        current_id = track["id"].GetInt();
-    }
+  if(res->Status() != 200) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue request received bad status code from api");
+    return -1;
+  }
 
-    if(queue_length == 0 || current_id < 0) {
-      spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue appears to be empty, even after loading in new version");
-      return false;
-    }
+  loftili::audio::Queue::Listing listing = Parse(*res);
 
-    m_stateclient.Update("current_track", current_id);
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("updated current_track device state to id[{0}]", current_id);
+  loftili::lib::metrics.Increment("api.queue.fetched");
+  m_etag = res->Header("ETag");
+  m_modified = res->Header("Last-Modified");
+  m_head = listing.head;
+  m_next = listing.next;
+  m_stale = false;
+  return m_head;
+}
 
-    if(!player.Play()) return false;
+// asks the reactor which track follows current_id without waiting for the
+// answer. the request is conditional on the copy of the queue we hold, which
+// stays the playback thread's; the answer only ever goes into the lookahead.
+std::shared_ptr<Queue::Lookahead> Queue::Lookup(int current_id) {
+  std::shared_ptr<Lookahead> ahead(new Lookahead());
+  ahead->next = -1;
+  ahead->ready = false;
 
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("player appeared to finish the track, popping from api");
-    Pop();
-    return true;
-  }
+  loftili::net::HttpRequest req(loftili::net::Url(QueueUrl().c_str()));
+  req.Header(loftili::api::DeviceHeaders());
+
+  if(m_head >= 0 && m_etag.size() > 0)
+    req.Header("If-None-Match", m_etag);
+
+  if(m_head >= 0 && m_modified.size() > 0)
+    req.Header("If-Modified-Since", m_modified);
+
+  int known = m_head == current_id ? m_next : -1;
+
+  bool posted = loftili::net::reactor.Post([ahead, req, current_id, known]() {
+    loftili::net::HttpTransfer::Start(req, loftili::net::HttpBodyCallback(), [ahead, current_id, known](std::shared_ptr<loftili::net::HttpResponse> res, bool) {
+      if(res && res->Status() == 304) {
+        loftili::lib::metrics.Increment("api.queue.not_modified");
+        ahead->next = known;
+      } else if(res && res->Status() == 200) {
+        loftili::audio::Queue::Listing listing = Parse(*res);
+        loftili::lib::metrics.Increment("api.queue.fetched");
+        ahead->next = listing.head == current_id ? listing.next : -1;
+      } else {
+        spdlog::get(LOFTILI_SPDLOG_ID)->warn("queue lookahead failed, not prefetching");
+      }
+
+      ahead->ready = true;
+    });
+  });
+
+  if(!posted) ahead->ready = true;
+
+  return ahead;
+}
 
-  return false;
+Queue::Listing Queue::Parse(loftili::net::HttpResponse& res) {
+  loftili::api::JsonStream ss(res.Body().Data());
+  loftili::audio::Queue::Listing listing = {-1, -1};
+  loftili::lib::JsonBinding<loftili::audio::Queue::Listing> binding(listing);
+  binding.Bind("queue.0.id", &loftili::audio::Queue::Listing::head)
+         .Bind("queue.1.id", &loftili::audio::Queue::Listing::next);
+  binding.Parse(ss);
+  return listing;
 }
 
 const std::string Queue::QueueUrl() {
@@ -0,0 +1,115 @@
+#include "audio/resampler.h"
+
+namespace loftili {
+
+namespace audio {
+
+namespace {
+
+// the zeroth order modified bessel function, for the kaiser window
+double Bessel(double x) {
+  double sum = 1.0, term = 1.0;
+
+  for(int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+
+  return sum;
+}
+
+long Divisor(long a, long b) {
+  while(b != 0) {
+    long t = a % b;
+    a = b;
+    b = t;
+  }
+
+  return a;
+}
+
+}
+
+bool Resampler::Configure(long from, long to, const loftili::audio::ConvertKernels& kernels) {
+  if(from <= 0 || to <= 0) return false;
+
+  long divisor = Divisor(from, to);
+  m_up = to / divisor;
+  m_down = from / divisor;
+  m_kernels = &kernels;
+
+  if(m_up > LOFTILI_RESAMPLE_MAX_PHASES) return false;
+
+  // going down in rate the filter has to cut lower, which takes more taps to
+  // do as sharply; the count is kept to whole vectors of stereo frames
+  m_taps = LOFTILI_RESAMPLE_TAPS * ((m_down + m_up - 1) / m_up);
+  m_taps = (m_taps + 3) / 4 * 4;
+
+  size_t length = m_up * m_taps;
+  double cutoff = 0.5 * LOFTILI_RESAMPLE_PASSBAND / std::max(m_up, m_down);
+  double centre = (length - 1) / 2.0;
+  std::vector<double> prototype(length);
+  double total = 0.0;
+
+  for(size_t k = 0; k < length; k++) {
+    double t = k - centre;
+    double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+    double r = t / (centre + 1.0);
+    prototype[k] = sinc * Bessel(LOFTILI_RESAMPLE_KAISER_BETA * sqrt(std::max(0.0, 1.0 - r * r))) / Bessel(LOFTILI_RESAMPLE_KAISER_BETA);
+    total += prototype[k];
+  }
+
+  // phase p weighs input frame i - m by prototype[m * up + p]. each phase is
+  // stored oldest frame first and with every coefficient doubled for the two
+  // channels, so it lines up with the history as it sits in memory.
+  m_filter.assign(length * 2, 0.0f);
+
+  for(size_t p = 0; p < m_up; p++) {
+    for(size_t m = 0; m < m_taps; m++) {
+      float coefficient = (float) (prototype[m * m_up + p] * m_up / total);
+      size_t at = (p * m_taps + (m_taps - 1 - m)) * 2;
+      m_filter[at] = m_filter[at + 1] = coefficient;
+    }
+  }
+
+  Reset();
+  return true;
+}
+
+void Resampler::Reset() {
+  m_history.assign((m_taps > 0 ? m_taps - 1 : 0) * 2, 0.0f);
+  m_index = m_taps > 0 ? m_taps - 1 : 0;
+  m_phase = 0;
+}
+
+// appends the frames made from the input to out, returning how many there were
+size_t Resampler::Process(const float* in, size_t frames, std::vector<float>& out) {
+  m_history.insert(m_history.end(), in, in + frames * 2);
+
+  size_t available = m_history.size() / 2, made = 0, span = m_taps * 2;
+  size_t start = out.size();
+  out.resize(start + ((available - m_index) * m_up / m_down + 1) * 2);
+
+  while(m_index < available) {
+    const float* window = m_history.data() + (m_index + 1 - m_taps) * 2;
+    m_kernels->fir(window, m_filter.data() + m_phase * span, span, out.data() + start + made * 2);
+    made++;
+
+    m_phase += m_down;
+    m_index += m_phase / m_up;
+    m_phase %= m_up;
+  }
+
+  out.resize(start + made * 2);
+
+  // only the frames the next output still reaches back over are kept
+  size_t keep = m_index + 1 - m_taps;
+  if(keep > available) keep = available;
+  m_history.erase(m_history.begin(), m_history.begin() + keep * 2);
+  m_index -= keep;
+  return made;
+}
+
+}
+
+}
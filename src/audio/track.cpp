@@ -0,0 +1,167 @@
+#include "audio/track.h"
+
+namespace loftili {
+
+namespace audio {
+
+Track::Track() : rate(0), channels(0), encoding(0), m_handle(NULL), m_download(new Download()), m_cache(NULL), m_input(LOFTILI_FEED_READ_SIZE),
+  m_id(-1), m_cached(false), m_primed(false), m_started(false) {
+  m_download->status = 0;
+  m_download->timed_out = false;
+}
+
+Track::~Track() {
+  mpg123_handle* handle = Release();
+  if(handle != NULL) mpg123_delete(handle);
+}
+
+// decodes with a handle lent by whoever plays the track, set up as they want
+// it; the stream is opened on it here and closed again by Release.
+bool Track::Open(const std::string& url, int id, loftili::audio::TrackCache* cache, mpg123_handle* handle) {
+  m_url = url;
+  m_id = id;
+  m_cache = cache;
+  m_handle = handle;
+
+  if(m_handle == NULL || mpg123_open_feed(m_handle) != MPG123_OK) return false;
+
+  std::shared_ptr<Download> download = m_download;
+
+  if(!loftili::net::reactor.Post([download, url, id, cache]() { Request(download, url, id, cache); }))
+    m_download->feed.Finish(false);
+
+  return true;
+}
+
+// a cached track is decoded straight from its file; there is nothing to
+// download, so the feed is finished before it is ever read.
+bool Track::Load(const std::string& path, int id, mpg123_handle* handle) {
+  m_url = path;
+  m_id = id;
+  m_cached = true;
+  m_download->feed.Finish(true);
+  m_handle = handle;
+  return m_handle != NULL && mpg123_open(m_handle, path.c_str()) == MPG123_OK;
+}
+
+// stops the download and hands the handle back, closed and ready for the
+// next track to open a stream on.
+mpg123_handle* Track::Release() {
+  Abandon();
+
+  mpg123_handle* handle = m_handle;
+  if(handle != NULL) mpg123_close(handle);
+  m_handle = NULL;
+  return handle;
+}
+
+// the reactor is asked to drop the connection rather than wait for the
+// next read to find the feed abandoned.
+void Track::Abandon() {
+  std::shared_ptr<Download> download = m_download;
+  download->feed.Abandon();
+
+  loftili::net::reactor.Post([download]() {
+    if(download->transfer) download->transfer->Cancel();
+  });
+}
+
+// fetches the track on the reactor, handing each read to the decoder as it
+// arrives and a copy to the cache. whatever happens the feed is finished, so
+// the decoder always wakes up; only a complete download is committed to the
+// cache.
+void Track::Request(std::shared_ptr<Download> download, const std::string& url, int id, loftili::audio::TrackCache* cache) {
+  loftili::net::HttpRequest req(loftili::net::Url(url.c_str()));
+
+  if(cache != NULL) download->writer = cache->Insert(id);
+
+  download->transfer = loftili::net::HttpTransfer::Start(req, [download](const char *data, int size) {
+    if(download->writer && !download->writer->Write(data, size)) download->writer.reset();
+    return download->feed.Write(data, size);
+  }, [download](std::shared_ptr<loftili::net::HttpResponse> res, bool timed_out) {
+    bool ok = res && res->Status() == 200;
+    download->status = res ? res->Status() : 0;
+    download->timed_out = timed_out;
+
+    if(ok && download->writer)
+      download->writer->Commit();
+
+    download->writer.reset();
+    download->transfer.reset();
+    download->feed.Finish(ok);
+  });
+}
+
+// moves the next read of the download into the decoder, MPG123_DONE once
+// there is nothing left to move.
+int Track::Feed() {
+  size_t received = m_download->feed.Read(m_input.data(), m_input.size());
+
+  if(received == 0) return MPG123_DONE;
+
+  return mpg123_feed(m_handle, m_input.data(), received);
+}
+
+// reads until the stream's format is known. a track that is about to play
+// waits for the prebuffer first; one primed in the background only takes what
+// has already arrived, and returns false if that wasn't enough yet.
+bool Track::Prime(bool wait) {
+  if(m_primed) return true;
+
+  if(wait) m_download->feed.Wait(LOFTILI_PREBUFFER_BYTES);
+
+  while(true) {
+    int err = mpg123_getformat(m_handle, &rate, &channels, &encoding);
+
+    if(err == MPG123_OK) {
+      m_primed = true;
+      return true;
+    }
+
+    if(err != MPG123_NEED_MORE) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->critical("invalid mpg123 format detected [{0}]", m_url.c_str());
+      return false;
+    }
+
+    if(!wait && m_download->feed.Buffered() == 0) return false;
+
+    if((err = Feed()) != MPG123_OK) {
+      if(err == MPG123_DONE)
+        spdlog::get(LOFTILI_SPDLOG_ID)->critical("stream from [{0}] ended before any audio was found", m_url.c_str());
+      return false;
+    }
+  }
+}
+
+// decodes the next block of samples, feeding the decoder from the download
+// as it runs out. returns MPG123_DONE once the download has been decoded.
+int Track::Read(unsigned char* buffer, size_t size, size_t* done) {
+  while(true) {
+    int err = mpg123_read(m_handle, buffer, size, done);
+
+    // the stream changed format midway; whoever is playing it has to follow
+    if(err == MPG123_NEW_FORMAT) {
+      mpg123_getformat(m_handle, &rate, &channels, &encoding);
+      return err;
+    }
+
+    if(err != MPG123_NEED_MORE || *done > 0) {
+      m_started = m_started || *done > 0;
+      return err == MPG123_NEED_MORE ? MPG123_OK : err;
+    }
+
+    // the network fell behind playback; wait for a full prebuffer again
+    // rather than stuttering through one read at a time.
+    if(m_started && m_download->feed.Buffered() == 0 && !m_download->feed.Finished()) {
+      loftili::lib::metrics.Increment("audio.stream.rebuffers");
+      spdlog::get(LOFTILI_SPDLOG_ID)->warn("stream from [{0}] ran dry, rebuffering", m_url.c_str());
+      m_download->feed.Wait(LOFTILI_PREBUFFER_BYTES);
+    }
+
+    if((err = Feed()) != MPG123_OK) return err;
+  }
+}
+
+}
+
+}
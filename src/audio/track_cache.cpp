@@ -0,0 +1,340 @@
+#include "audio/track_cache.h"
+
+namespace loftili {
+
+namespace audio {
+
+TrackCache::~TrackCache() {
+  if(m_index != NULL) munmap(m_index, sizeof(Index));
+  if(m_handle >= 0) close(m_handle);
+}
+
+// maps the index, starting it over if it is missing or from another version,
+// and clears out whatever a crash may have left behind.
+bool TrackCache::Open(const std::string& path, long budget) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(m_index != NULL) return true;
+
+  m_path = path;
+  m_budget = budget;
+  mkdir(m_path.c_str(), 0700);
+
+  std::string index = m_path + "/index";
+  struct stat info;
+
+  if((m_handle = open(index.c_str(), O_RDWR | O_CREAT, 0600)) < 0 || fstat(m_handle, &info) != 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to open track cache index {0}: {1}", index, strerror(errno));
+    return false;
+  }
+
+  bool fresh = info.st_size != (off_t) sizeof(Index);
+
+  if(fresh && (ftruncate(m_handle, 0) != 0 || ftruncate(m_handle, sizeof(Index)) != 0)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to size track cache index {0}: {1}", index, strerror(errno));
+    return false;
+  }
+
+  void* mapped = mmap(NULL, sizeof(Index), PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
+
+  if(mapped == MAP_FAILED) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to map track cache index {0}: {1}", index, strerror(errno));
+    return false;
+  }
+
+  m_index = (Index*) mapped;
+
+  if(fresh || m_index->header.magic != LOFTILI_CACHE_MAGIC || m_index->header.version != LOFTILI_CACHE_VERSION || m_index->header.slots != LOFTILI_CACHE_SLOTS) {
+    memset(m_index, 0, sizeof(Index));
+    m_index->header.magic = LOFTILI_CACHE_MAGIC;
+    m_index->header.version = LOFTILI_CACHE_VERSION;
+    m_index->header.slots = LOFTILI_CACHE_SLOTS;
+    Sync();
+  }
+
+  Sweep();
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("track cache opened at {0} holding {1} of {2} bytes", m_path, m_bytes, m_budget);
+  return true;
+}
+
+// drops records whose file has gone, then any cache file no record points
+// at. only names the cache itself would have made are ever removed, so a
+// cache directory shared with anything else leaves the rest alone.
+void TrackCache::Sweep() {
+  struct stat info;
+  m_bytes = 0;
+
+  for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+    Record& record = m_index->records[i];
+    if(record.track == 0) continue;
+
+    if(stat(FilePath(record.hash).c_str(), &info) != 0 || (uint64_t) info.st_size != record.size) {
+      record.track = 0;
+      continue;
+    }
+  }
+
+  // files shared by several ids only count once towards the budget
+  for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+    Record& record = m_index->records[i];
+    bool counted = false;
+
+    for(int j = 0; j < i && record.track != 0 && !counted; j++)
+      counted = m_index->records[j].track != 0 && memcmp(m_index->records[j].hash, record.hash, sizeof(record.hash)) == 0;
+
+    if(record.track != 0 && !counted) m_bytes += record.size;
+  }
+
+  Sync();
+
+  DIR* dir = opendir(m_path.c_str());
+  if(dir == NULL) return;
+
+  struct dirent* entry;
+
+  while((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if(!Ours(name)) continue;
+
+    bool known = false;
+
+    for(int i = 0; i < LOFTILI_CACHE_SLOTS && !known; i++) {
+      Record& record = m_index->records[i];
+      known = record.track != 0 && m_path + "/" + name == FilePath(record.hash);
+    }
+
+    if(!known) unlink((m_path + "/" + name).c_str());
+  }
+
+  closedir(dir);
+}
+
+// a hit hands back the file to play and makes the track the most recent one
+bool TrackCache::Find(int track, std::string& path) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if(m_index == NULL || track <= 0) return false;
+
+  for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+    Record& record = m_index->records[i];
+    if(record.track != track) continue;
+
+    struct stat info;
+    path = FilePath(record.hash);
+
+    if(stat(path.c_str(), &info) != 0 || (uint64_t) info.st_size != record.size) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->warn("cached file for track[{0}] is gone, dropping it", track);
+      Evict(record);
+      break;
+    }
+
+    record.used = ++m_index->header.clock;
+    loftili::lib::metrics.Increment("audio.cache.bytes_saved", record.size);
+    Hit(track, true);
+    return true;
+  }
+
+  Hit(track, false);
+  return false;
+}
+
+// every lookup logs where the cache stands, and puts the rate and the bytes
+// saved (zero until the first hit) into the periodic metrics report.
+void TrackCache::Hit(int track, bool hit) {
+  long hits = loftili::lib::metrics.Increment("audio.cache.hits", hit ? 1 : 0);
+  long misses = loftili::lib::metrics.Increment("audio.cache.misses", hit ? 0 : 1);
+  long saved = loftili::lib::metrics.Increment("audio.cache.bytes_saved", 0);
+  long rate = hits * 100 / (hits + misses);
+  loftili::lib::metrics.Set("audio.cache.hit_rate", rate);
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("track cache {0} for track[{1}], hit rate [{2}]% over [{3}] lookups, [{4}] bytes saved",
+    hit ? "hit" : "miss", track, rate, hits + misses, saved);
+}
+
+std::unique_ptr<loftili::audio::TrackCache::Writer> TrackCache::Insert(int track) {
+  std::unique_ptr<loftili::audio::TrackCache::Writer> writer;
+
+  if(m_index == NULL || track <= 0) return writer;
+
+  std::stringstream name;
+  name << m_path << "/" << track << "." << getpid() << ".tmp";
+  int handle = open(name.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  if(handle < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to cache track[{0}]: {1}", track, strerror(errno));
+    return writer;
+  }
+
+  writer.reset(new loftili::audio::TrackCache::Writer(*this, track, handle, name.str()));
+  return writer;
+}
+
+// moves a finished download into place and points a record at it, making room
+// by dropping the least recently played tracks first.
+bool TrackCache::Store(int track, const std::string& temporary, const unsigned char* hash, uint64_t size) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  if((long) size > m_budget) {
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  Record* slot = NULL;
+
+  for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+    Record& record = m_index->records[i];
+    if(record.track == track) Evict(record);
+    if(record.track == 0 && slot == NULL) slot = &record;
+  }
+
+  // the same contents under another id already has its file
+  bool shared = Shared(hash, NULL);
+
+  while(slot == NULL || (!shared && m_bytes + (long) size > m_budget)) {
+    Record* oldest = NULL;
+
+    for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+      Record& record = m_index->records[i];
+      if(record.track != 0 && (oldest == NULL || record.used < oldest->used)) oldest = &record;
+    }
+
+    if(oldest == NULL) break;
+
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("track cache evicting track[{0}] to make room", oldest->track);
+    loftili::lib::metrics.Increment("audio.cache.evictions");
+    Evict(*oldest);
+    shared = Shared(hash, NULL);
+    if(slot == NULL) slot = oldest;
+  }
+
+  std::string path = FilePath(hash);
+
+  if(slot == NULL) {
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  if(shared) {
+    unlink(temporary.c_str());
+  } else if(rename(temporary.c_str(), path.c_str()) != 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to move track[{0}] into the cache: {1}", track, strerror(errno));
+    unlink(temporary.c_str());
+    return false;
+  }
+
+  memcpy(slot->hash, hash, sizeof(slot->hash));
+  slot->size = size;
+  slot->used = ++m_index->header.clock;
+  Sync();
+  slot->track = track;
+  Sync();
+
+  if(!shared) m_bytes += size;
+  loftili::lib::metrics.Set("audio.cache.bytes", m_bytes);
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("track cache stored track[{0}] as {1}", track, path);
+  return true;
+}
+
+void TrackCache::Evict(Record& record) {
+  record.track = 0;
+  Sync();
+
+  if(Shared(record.hash, &record)) return;
+
+  unlink(FilePath(record.hash).c_str());
+  m_bytes -= record.size;
+  loftili::lib::metrics.Set("audio.cache.bytes", m_bytes);
+}
+
+// whether any record other than the one given holds these contents
+bool TrackCache::Shared(const unsigned char* hash, const Record* except) {
+  for(int i = 0; i < LOFTILI_CACHE_SLOTS; i++) {
+    const Record& record = m_index->records[i];
+    if(&record != except && record.track != 0 && memcmp(record.hash, hash, sizeof(record.hash)) == 0) return true;
+  }
+
+  return false;
+}
+
+void TrackCache::Sync() {
+  msync(m_index, sizeof(Index), MS_SYNC);
+}
+
+std::string TrackCache::FilePath(const unsigned char* hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string path = m_path + "/";
+
+  for(int i = 0; i < 32; i++) {
+    path.push_back(digits[hash[i] >> 4]);
+    path.push_back(digits[hash[i] & 0x0f]);
+  }
+
+  return path + ".mp3";
+}
+
+// "<sha-256 in hex>.mp3" for a cached file, "<track>.<pid>.tmp" for one
+// still being written
+bool TrackCache::Ours(const std::string& name) {
+  size_t dot = name.find('.');
+
+  if(name.size() == 68 && dot == 64 && name.compare(64, 4, ".mp3") == 0)
+    return name.find_first_not_of("0123456789abcdef") == dot;
+
+  size_t second = name.find('.', dot + 1);
+
+  if(dot == 0 || dot == std::string::npos || second == dot + 1 || second == std::string::npos || name.compare(second, std::string::npos, ".tmp") != 0)
+    return false;
+
+  return name.find_first_not_of("0123456789") == dot && name.find_first_not_of("0123456789", dot + 1) == second;
+}
+
+TrackCache::Writer::Writer(loftili::audio::TrackCache& cache, int track, int handle, const std::string& path) :
+  m_cache(cache), m_digest(EVP_MD_CTX_create()), m_path(path), m_size(0), m_track(track), m_handle(handle) {
+  EVP_DigestInit_ex(m_digest, EVP_sha256(), NULL);
+}
+
+TrackCache::Writer::~Writer() {
+  if(m_handle >= 0) {
+    close(m_handle);
+    unlink(m_path.c_str());
+  }
+
+  EVP_MD_CTX_destroy(m_digest);
+}
+
+bool TrackCache::Writer::Write(const char* data, size_t size) {
+  if(m_handle < 0) return false;
+
+  EVP_DigestUpdate(m_digest, data, size);
+  m_size += size;
+
+  while(size > 0) {
+    ssize_t written = write(m_handle, data, size);
+    if(written < 0 && errno == EINTR) continue;
+    if(written <= 0) return false;
+    data += written;
+    size -= written;
+  }
+
+  return true;
+}
+
+bool TrackCache::Writer::Commit() {
+  unsigned char hash[EVP_MAX_MD_SIZE];
+  unsigned int length = 0;
+  EVP_DigestFinal_ex(m_digest, hash, &length);
+
+  bool ok = fsync(m_handle) == 0;
+  ok = close(m_handle) == 0 && ok;
+  m_handle = -1;
+
+  if(!ok || length != 32) {
+    unlink(m_path.c_str());
+    return false;
+  }
+
+  return m_cache.Store(m_track, m_path, hash, m_size);
+}
+
+}
+
+}
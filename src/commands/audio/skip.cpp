@@ -7,14 +7,14 @@ namespace commands {
 
 namespace audio {
 
-void Skip::Execute(loftili::Engine *engine) {
+void Skip::Execute(loftili::Engine *engine, const std::string&) {
   loftili::audio::Playback *playback = engine->Get<loftili::audio::Playback>();
   if(!playback) return;
   playback->Skip();
 }
 
-void Skip::operator()(loftili::Engine *engine) {
-  return Execute(engine);
+void Skip::operator()(loftili::Engine *engine, const std::string& arguments) {
+  return Execute(engine, arguments);
 }
 
 }
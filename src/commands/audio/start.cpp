@@ -7,14 +7,14 @@ namespace commands {
 
 namespace audio {
 
-void Start::Execute(loftili::Engine *engine) {
+void Start::Execute(loftili::Engine *engine, const std::string&) {
   loftili::audio::Playback *playback = engine->Get<loftili::audio::Playback>();
   if(!playback) return;
   playback->Start();
 }
 
-void Start::operator()(loftili::Engine *engine) {
-  return Execute(engine);
+void Start::operator()(loftili::Engine *engine, const std::string& arguments) {
+  return Execute(engine, arguments);
 }
 
 }
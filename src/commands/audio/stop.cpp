@@ -7,14 +7,14 @@ namespace commands {
 
 namespace audio {
 
-void Stop::Execute(loftili::Engine *engine) {
+void Stop::Execute(loftili::Engine *engine, const std::string&) {
   loftili::audio::Playback *playback = engine->Get<loftili::audio::Playback>();
   if(!playback) return;
   playback->Stop();
 }
 
-void Stop::operator()(loftili::Engine *engine) {
-  return Execute(engine);
+void Stop::operator()(loftili::Engine *engine, const std::string& arguments) {
+  return Execute(engine, arguments);
 }
 
 }
@@ -3,10 +3,12 @@
 namespace loftili {
 
 int Engine::Initialize(int argc, char* argv[]) {
+  m_boot = std::chrono::steady_clock::now();
   int i = 1;
   char *p;
 
-  std::string serial_no, logfile = LOFTILI_LOG_PATH;
+  std::string serial_no, logfile = LOFTILI_LOG_PATH, period, buffer, rate;
+  loftili::audio::SinkConfiguration& sink = loftili::audio::sink_configuration;
   loftili::net::Url api_url = LOFTILI_API_PRODUCTION;
   bool verbose = false;
 
@@ -59,6 +61,52 @@ int Engine::Initialize(int argc, char* argv[]) {
             continue;
           }
           break;
+        case 'o':
+          sink.backend = *p ? p : (argv[++i] ? argv[i] : "");
+          if(!loftili::audio::AudioSink::Known(sink.backend)) {
+            printf("invalid output argument [%s]\n", sink.backend.c_str());
+            return DisplayHelp();
+          }
+          f = true;
+          continue;
+        case 'd':
+          if(*p) {
+            sink.device = p;
+            f = true;
+            continue;
+          }
+          if(argv[++i]) {
+            sink.device = argv[i];
+            f = true;
+            continue;
+          }
+          break;
+        case 'p':
+          period = *p ? p : (argv[++i] ? argv[i] : "");
+          if((sink.period = atoi(period.c_str())) <= 0) {
+            printf("invalid period argument [%s]\n", period.c_str());
+            return DisplayHelp();
+          }
+          f = true;
+          continue;
+        case 'b':
+          buffer = *p ? p : (argv[++i] ? argv[i] : "");
+          if((sink.buffer = atoi(buffer.c_str())) <= 0) {
+            printf("invalid buffer argument [%s]\n", buffer.c_str());
+            return DisplayHelp();
+          }
+          f = true;
+          continue;
+        case 'r':
+          rate = *p ? p : (argv[++i] ? argv[i] : "");
+          if((sink.rate = atoi(rate.c_str())) < 8000) {
+            printf("invalid rate argument [%s]\n", rate.c_str());
+            return DisplayHelp();
+          }
+          f = true;
+          continue;
+        case 'k':
+          return Benchmark();
         default:
           printf("unrecognized option (%s)\n", --p);
           return DisplayHelp();
@@ -90,6 +138,9 @@ int Engine::Initialize(int argc, char* argv[]) {
     close(STDIN_FILENO);
   }
 
+  // a peer closing while we write must surface as an error, not kill the process
+  signal(SIGPIPE, SIG_IGN);
+
   loftili::api::configuration.serial = serial_no;
   spdlog::set_level(spdlog::level::info);
 
@@ -99,6 +150,7 @@ int Engine::Initialize(int argc, char* argv[]) {
     : (api_url.Protocol() == "http" ? 80 : 443);
 
   lof->info("configuring engine - api[{0}:{1}]", loftili::api::configuration.hostname, loftili::api::configuration.port, api_url.Port());
+  lof->info("configuring engine - output[{0}] device[{1}]", sink.backend, sink.device);
   return 1;
 }
 
@@ -110,118 +162,260 @@ int Engine::DisplayHelp() {
   printf("        -%s %-*s %s", "s", 15, "SERIAL", "\e[0;36m[required]\e[0m the serial number this device was given\n");
   printf("        -%s %-*s %s", "a", 15, "API HOST", "if running the api on your own, use this param (defaults to https://api.loftili.com)\n");
   printf("        -%s %-*s %s", "l", 15, "LOGFILE", "the file path used for the log file. ignored if -v (defaults to loftili.log)\n");
+  printf("        -%s %-*s %s", "o", 15, "OUTPUT", "where audio is played: ao, alsa, file or null (defaults to ao)\n");
+  printf("        -%s %-*s %s", "d", 15, "DEVICE", "the alsa device, or the file raw samples are written to with -o file\n");
+  printf("        -%s %-*s %s", "p", 15, "PERIOD", "alsa period size in frames (defaults to 1024)\n");
+  printf("        -%s %-*s %s", "b", 15, "BUFFER", "alsa buffer size in frames (defaults to 4096)\n");
+  printf("        -%s %-*s %s", "r", 15, "RATE", "the sample rate every track is converted to for the device (defaults to 44100)\n");
+  printf("        -%s %-*s %s", "k", 15, "", "time the http parser, measure download memory and time the sample conversion kernels this machine supports and exit\n");
   printf("        -%s %-*s %s", "v", 15, "VERBOSE", "runs loftili core in foreground - log messages to stdout (development mode)\n");
   printf("        -%s %-*s %s", "h", 15, "", "display this help text \n\n");
   return 0;
 }
 
+// -k: prints how fast this machine runs the code every download and every
+// sample goes through, then exits
+int Engine::Benchmark() {
+  printf("\e[4;32mloftili core v%s benchmarks\e[0m\n\n", PACKAGE_VERSION);
+  loftili::net::HttpParser::Benchmark();
+  printf("\n");
+  loftili::net::HttpResponse::Benchmark();
+  printf("\n");
+  loftili::audio::Converter::Benchmark();
+  return 0;
+}
+
+// everything from registration on happens on the reactor, which runs here
+// until the engine gives up.
 int Engine::Run() {
-  INFO("telling playback to skip in case we were shut down");
-  loftili::audio::Playback *p;
-  if((p = Get<loftili::audio::Playback>())) p->Skip();
+  loftili::net::reactor.Post([this]() { Start(); });
 
-  INFO("opening command stream to api server");
+  // everything counted along the way is logged on a timer, and once more on the way out
+  loftili::net::reactor.Timer(LOFTILI_METRICS_REPORT_MS, []() { loftili::lib::metrics.Report(); }, LOFTILI_METRICS_REPORT_MS);
 
-  if(Subscribe() < 0) {
-    CRITICAL("received invalid response from server during subscription request");
-    return -1;
-  }
+  loftili::net::reactor.Run();
 
-  int retries = 0;
-  loftili::net::CommandStream cs;
-  INFO("subscription finished, attempting to read into command stream");
+  CRITICAL_2("engine stream exited after [{0}] retries", m_policy.Attempts());
+  loftili::lib::metrics.Report();
 
-  while(retries < MAX_ENGINE_RETRIES) {
-    m_state = ENGINE_STATE_READING;
-    m_thread = std::thread(&Engine::KeepAlive, this);
+  return m_result;
+};
 
-    while(cs << m_socket) {
-      std::shared_ptr<loftili::net::GenericCommand> gc = cs.Latest();
-      INFO("received command, executing command");
-      (*gc.get())(this);
-      cs.Pop();
-      retries = 0;
+void Engine::Start() {
+  Register([this](bool registered) {
+    if(!registered) {
+      CRITICAL("unable to register device, shutting down");
+      m_result = -1;
+      loftili::net::reactor.Stop();
+      return;
     }
 
-    WARN_2("engine stream reached bad state, retrying in 2 seconds. attempt [{0}]", ++retries);
-    m_state = ENGINE_STATE_ERRORED;
+    RenderPing();
 
-    if(m_thread.joinable()) {
-      INFO("joining KeepAlive thread...");
-      m_thread.join();
-    }
+    INFO("telling playback to skip in case we were shut down");
+    loftili::audio::Playback *p;
+    if((p = Get<loftili::audio::Playback>())) p->Skip();
+
+    INFO("opening command stream to api server");
 
-    sleep(3);
+    Subscribe([this](bool subscribed) {
+      if(subscribed) {
+        INFO("subscription finished, reading command stream from reactor");
+        return;
+      }
 
-    INFO("waking up after 3 second sleep, attempting to re-subscribe");
+      CRITICAL("received invalid response from server during subscription request");
+      m_result = -1;
+      loftili::net::reactor.Stop();
+    });
+  });
+}
 
-    if(Subscribe() > 0) {
-      INFO("engine recovered from anomoly, continuing with next read");
-      continue;
-    }
+void Engine::Receive() {
+  int pongs = m_stream.Pongs();
+  bool ok = m_stream << m_socket;
 
-    CRITICAL("engine unable to recover from anomoly, shutting down");
-    m_state = ENGINE_STATE_ERRORED;
-    break;
+  m_heartbeat.Activity();
+
+  bool answered = pongs < m_stream.Pongs();
+
+  for(; pongs < m_stream.Pongs(); pongs++)
+    m_heartbeat.Pong();
+
+  if(answered) m_policy.Settle();
+
+  // the api no longer accepts the token we subscribed (or pinged) with
+  bool rejected = answered && (m_stream.Status() == 401 || m_stream.Status() == 403);
+
+  if(rejected)
+    WARN_2("api rejected our credentials with status[{0}], registering again", m_stream.Status());
+
+  while(m_stream.Size() > 0) {
+    loftili::net::GenericCommand& command = m_stream.Latest();
+    INFO("received command, executing command");
+    command(this, command.Arguments());
+    m_stream.Pop();
   }
 
-  if(m_thread.joinable()) {
-    m_thread.join();
+  // nothing more is read from the stream until there are new credentials
+  // to subscribe with
+  if(rejected) {
+    loftili::net::reactor.Unwatch(m_socket.Handle());
+    m_heartbeat.Stop();
+    Reauthorize([this](bool) { Reconnect(); });
+    return;
   }
 
-  CRITICAL_2("engine stream exited after [{0}] retries", retries);
+  if(!ok) Reconnect();
+}
 
-  return 0;
-};
+void Engine::Reconnect() {
+  loftili::net::reactor.Unwatch(m_socket.Handle());
+  m_socket = loftili::net::TcpSocket(loftili::net::impl::Derived());
+  m_heartbeat.Lost();
+  m_policy.Lost();
+
+  if(m_policy.Attempts() >= MAX_ENGINE_RETRIES) {
+    CRITICAL("engine unable to recover from anomoly, shutting down");
+    loftili::net::reactor.Stop();
+    return;
+  }
+
+  int delay = m_policy.Next();
+  spdlog::get(LOFTILI_SPDLOG_ID)->warn("engine stream reached bad state, retrying in [{0}]ms. attempt [{1}]", delay, m_policy.Attempts());
+
+  loftili::net::reactor.Timer(delay, [this]() {
+    INFO("attempting to re-subscribe");
+
+    Subscribe([this](bool subscribed) {
+      if(!subscribed) {
+        Reconnect();
+        return;
+      }
+
+      INFO("engine recovered from anomoly, continuing with next read");
+    });
+  });
+}
 
+// a ping that doesn't fit in the send buffer straight away means the link is gone
 bool Engine::KeepAlive() {
-  INFO("keep alive thread started, sending occasional pings to server");
-
-  while(m_state == ENGINE_STATE_READING) {
-    std::stringstream r;
-    r << "GET /system HTTP/1.1\n";
-    r << "Connection: Keep-alive\n";
-    r << "Host: " << loftili::api::configuration.hostname << "\n";
-    r << "Content-Length: 0\n";
-    r << LOFTILI_API_TOKEN_HEADER << ": " << loftili::api::credentials.token << "\n";
-    r << LOFTILI_API_SERIAL_HEADER << ": " << loftili::api::configuration.serial;
-    r << "\r\n\r\n";
-    std::string ka_req = r.str();
-    int s = m_socket.Write(ka_req.c_str(), ka_req.length());
-
-    if(s != ka_req.size()) {
-      WARN_2("keep alive ping unable to write... {0} bytes sent", s);
-      m_state = ENGINE_STATE_ERRORED;
-      break;
-    }
+  int s = m_socket.Write(m_ping.c_str(), m_ping.size());
 
-    sleep(1);
-  }
+  if(s == (int) m_ping.size())
+    return true;
 
+  WARN_2("keep alive ping unable to write... {0} bytes sent", s);
+  Reconnect();
   return false;
 }
 
-int Engine::Register() {
+// a restart reuses the credentials saved by the last registration and only
+// asks the api again once it turns them down.
+void Engine::Register(Completion done) {
+  if(m_store.Load(loftili::api::configuration.serial, loftili::api::credentials)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("using saved credentials for device[{0}], skipping registration", loftili::api::credentials.device_id);
+    done(true);
+    return;
+  }
+
+  Reauthorize(done);
+};
+
+void Engine::Reauthorize(Completion done) {
   spdlog::get(LOFTILI_SPDLOG_ID)->info("beginning registration process...");
+  m_store.Clear();
+  loftili::api::credentials.token = "";
   loftili::api::Registration *registration = Get<loftili::api::Registration>();
-  return registration->Register();
-};
 
-int Engine::Subscribe() {
-  m_socket = loftili::net::TcpSocket(loftili::api::configuration.protocol == "https");
-  int ok = m_socket.Connect(loftili::api::configuration.hostname.c_str(), loftili::api::configuration.port);
-  if(ok < 0) return -1;
-
-  std::stringstream r;
-  r << "SUBSCRIBE /sockets/devices HTTP/1.1\n";
-  r << "Connection: Keep-alive\n";
-  r << "Host: " << loftili::api::configuration.hostname << "\n";
-  r << "Content-Length: 0\n";
-  r << LOFTILI_API_TOKEN_HEADER << ": " << loftili::api::credentials.token << "\n";
-  r << LOFTILI_API_SERIAL_HEADER << ": " << loftili::api::configuration.serial;
-  r << "\r\n\r\n";
-  std::string subscription_req = r.str();
-  return m_socket.Write(subscription_req.c_str(), subscription_req.length());
+  registration->Register([this, done](bool registered) {
+    if(registered) {
+      m_store.Save(loftili::api::configuration.serial, loftili::api::credentials);
+      RenderPing();
+    }
+
+    done(registered);
+  });
+}
+
+// the ping never changes between registrations, so it is rendered once and the
+// same bytes are reused for every beat.
+void Engine::RenderPing() {
+  loftili::net::Url system_url(ApiUrl("/system").c_str());
+  loftili::net::HttpRequest ping(system_url);
+  ping.Header("Connection", "keep-alive");
+  ping.Header(loftili::api::DeviceHeaders());
+  m_ping = ping;
+}
+
+// a warm standby only needs the SUBSCRIBE; if it fails to take that, a fresh
+// connection is opened on the reactor right away.
+void Engine::Subscribe(Completion done) {
+  bool is_ssl = loftili::api::configuration.protocol == "https";
+
+  if(m_policy.Take(m_socket)) {
+    INFO("subscribing over the standby connection");
+
+    if(Announce()) {
+      Subscribed(is_ssl);
+      done(true);
+      return;
+    }
+  }
+
+  loftili::net::TcpSocket socket(is_ssl);
+  socket.Limit(loftili::net::default_deadlines);
+
+  socket.Connect(loftili::net::reactor, loftili::api::configuration.hostname.c_str(), loftili::api::configuration.port, [this, socket, is_ssl, done](int result) {
+    if(result == LOFTILI_SOCKET_TIMEOUT)
+      WARN("timed out opening the command socket");
+
+    m_socket = socket;
+    bool ok = result >= 0 && Announce();
+
+    if(ok) Subscribed(is_ssl);
+    done(ok);
+  });
+}
+
+// the SUBSCRIBE is a few hundred bytes going out on a connection that has
+// sent nothing yet, so it always fits in one non-blocking write
+bool Engine::Announce() {
+  loftili::net::HttpRequest req(loftili::net::Url(ApiUrl("/sockets/devices").c_str()), "SUBSCRIBE");
+  req.Header("Connection", "keep-alive");
+  req.Header(loftili::api::DeviceHeaders());
+
+  struct iovec buffers[LOFTILI_REQUEST_MAX_BUFFERS];
+  int count = req.Buffers(buffers, LOFTILI_REQUEST_MAX_BUFFERS);
+
+  if(count < 0) return false;
+
+  m_socket.Blocking(false);
+  int written = m_socket.Write(buffers, count);
+  return written >= 0 && (size_t) written == req.Size();
+}
+
+// from here on the reactor reads the socket only when it is ready
+void Engine::Subscribed(bool is_ssl) {
+  loftili::net::reactor.Watch(m_socket.Handle(), loftili::net::Reactor::EVENT_READ, [this](int) { Receive(); });
+  m_heartbeat.Start(loftili::net::reactor, [this]() { return KeepAlive(); }, [this]() { Reconnect(); }, [this, is_ssl]() {
+    m_policy.Prepare(loftili::net::reactor, loftili::api::configuration.hostname, loftili::api::configuration.port, is_ssl);
+  });
+  m_policy.Recovered();
+
+  if(!m_subscribed) {
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_boot).count();
+    loftili::lib::metrics.Set("engine.boot_to_subscribed_ms", elapsed);
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("subscribed [{0}]ms after boot", elapsed);
+    m_subscribed = true;
+  }
+}
+
+std::string Engine::ApiUrl(const char* path) {
+  std::stringstream url;
+  url << loftili::api::configuration.protocol << "://";
+  url << loftili::api::configuration.hostname << ":" << loftili::api::configuration.port << path;
+  return url.str();
 }
 
 }
@@ -0,0 +1,27 @@
+#include "lib/backoff.h"
+
+namespace loftili {
+
+namespace lib {
+
+Backoff::Backoff(int base_ms, int cap_ms) : m_random(std::random_device()()), m_base(base_ms), m_cap(cap_ms), m_attempts(0) {
+}
+
+int Backoff::Next() {
+  long ceiling = m_base;
+
+  for(int i = 0; i < m_attempts && ceiling < m_cap; i++)
+    ceiling *= 2;
+
+  m_attempts++;
+  std::uniform_int_distribution<int> delay(0, (int) std::min<long>(ceiling, m_cap));
+  return delay(m_random);
+}
+
+void Backoff::Reset() {
+  m_attempts = 0;
+}
+
+}
+
+}
@@ -0,0 +1,40 @@
+#include "lib/metrics.h"
+
+namespace loftili {
+
+namespace lib {
+
+long Metrics::Increment(const std::string& name, long amount) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_values[name] += amount;
+}
+
+void Metrics::Set(const std::string& name, long value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_values[name] = value;
+}
+
+long Metrics::Get(const std::string& name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::map<std::string, long>::iterator it = m_values.find(name);
+  return it == m_values.end() ? 0 : it->second;
+}
+
+// logs a snapshot of every value as a single line, sorted by name
+void Metrics::Report() {
+  std::stringstream snapshot;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<std::string, long>::iterator it = m_values.begin();
+
+    for(; it != m_values.end(); ++it)
+      snapshot << (it == m_values.begin() ? "" : " ") << it->first << "=" << it->second;
+  }
+
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("[METRICS] {0}", snapshot.str());
+}
+
+}
+
+}
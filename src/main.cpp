@@ -6,8 +6,16 @@
 
 loftili::api::ApiConfiguration loftili::api::configuration = { };
 loftili::api::DeviceCredentials loftili::api::credentials = { "", -1 };
+loftili::lib::Metrics loftili::lib::metrics;
+loftili::net::Resolver loftili::net::resolver;
+loftili::net::TlsContext loftili::net::tls;
+loftili::net::ConnectionPool loftili::net::connections;
+loftili::net::Reactor loftili::net::reactor;
+loftili::net::CommandTable loftili::net::dispatch;
+loftili::api::StatePublisher loftili::api::publisher;
+loftili::audio::SinkConfiguration loftili::audio::sink_configuration = { "ao", "", 0, 0, 0 };
 
 int main(int argc, char* argv[]) {
   std::unique_ptr<loftili::Engine> p1 = std::unique_ptr<loftili::Engine>(new loftili::Engine());
-  return p1->Initialize(argc, argv) && p1->Register() && p1->Run();
+  return p1->Initialize(argc, argv) && p1->Run();
 }
@@ -4,39 +4,172 @@ namespace loftili {
 
 namespace net {
 
+namespace {
+
+// 1 when the bytes start with the token, 0 when they are a prefix of it that
+// more bytes could complete, -1 otherwise.
+int Prefix(const char *begin, const char *end, const char *token) {
+  size_t size = strlen(token), available = end - begin;
+  int match = strncmp(begin, token, std::min(size, available)) == 0;
+  if(!match) return -1;
+  return available >= size ? 1 : 0;
+}
+
+const char* Find(const char *begin, const char *end, const char *token) {
+  return std::search(begin, end, token, token + strlen(token));
+}
+
+}
+
+// drains everything the socket has ready; a non-blocking socket reports it is
+// empty with LOFTILI_SOCKET_WOULDBLOCK, which leaves the stream healthy.
 bool CommandStream::operator <<(loftili::net::TcpSocket& socket) {
-  char *buffer = (char*) malloc(sizeof(char) * 2048);
+  m_reader.Attach(socket);
+
+  while(true) {
+    int received = m_reader.Fill();
+
+    if(received == LOFTILI_SOCKET_WOULDBLOCK) {
+      Frame(true);
+      return true;
+    }
 
-  INFO("[OPENING] command stream opening up read attempt from engine socket");
-  int received = socket.Read(buffer, 2048);
-  INFO_2("[RECEIVED] read attempt has finished receiving bytes[{0}]", received);
+    if(received <= 0) {
+      WARN("command stream\'s socket connection failed reading");
+      return false;
+    }
 
-  if(received <= 0) {
-    WARN("command stream\'s socket connection failed reading");
-    free(buffer);
-    return false;
+    Frame(false);
   }
+}
+
+// pulls every complete message off the front of the buffer. the server does
+// not always end its last message, so once the socket has been drained an
+// unterminated command is taken as complete if it names a known command;
+// anything else waits for the bytes (or the next message) that finish it.
+void CommandStream::Frame(bool drained) {
+  while(true) {
+    loftili::lib::ByteView buffered = m_reader.Buffered();
+    const char *begin = buffered.begin(), *end = buffered.end(), *start = begin;
 
-  char *cmd_break = strstr(buffer, "CMD");
+    while(start < end && (*start == '\r' || *start == '\n' || *start == ' ' || *start == '\0'))
+      start++;
 
-  if(cmd_break == nullptr || cmd_break - buffer > 0) {
-    spdlog::get(LOFTILI_SPDLOG_ID)->warn("command stream received a strange message from server");
-    free(buffer);
-    return false;
+    if(start != begin) {
+      m_reader.Consume(start - begin);
+      continue;
+    }
+
+    if(begin == end)
+      return;
+
+    int used = 0;
+
+    if(Prefix(begin, end, "CMD") > 0)
+      used = FrameCommand(begin, end, drained);
+    else if(Prefix(begin, end, "HTTP/") > 0)
+      used = FrameResponse(begin, end);
+    else if(Prefix(begin, end, "CMD") < 0 && Prefix(begin, end, "HTTP/") < 0)
+      used = Resync(begin, end);
+
+    if(used <= 0)
+      return;
+
+    m_reader.Consume(used);
   }
+}
+
+int CommandStream::FrameCommand(const char *begin, const char *end, bool drained) {
+  const char *stop = std::min(std::find(begin + 3, end, '\n'), 
+    std::min(Find(begin + 3, end, "CMD"), Find(begin + 3, end, "HTTP/")));
+
+  if(stop == end && !drained)
+    return 0;
+
+  const char *last = stop;
+
+  while(last > begin && (last[-1] == '\r' || last[-1] == ' '))
+    last--;
+
+  const char *colon = std::find(begin, last, ':');
 
-  buffer = (char*) realloc(buffer, sizeof(char) * (received + 1));
-  buffer[received] = '\0';
-  m_commands.push_back(std::shared_ptr<loftili::net::GenericCommand>(new loftili::net::GenericCommand(buffer)));
-  free(buffer);
-  return true;
+  if(stop == end && !loftili::net::GenericCommand::Known(begin, last - begin))
+    return 0;
+
+  if(colon == last || colon + 1 == last) {
+    if(stop == end) return 0;
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("command stream dropping malformed command [{0}]", std::string(begin, last - begin));
+    return stop - begin;
+  }
+
+  loftili::net::GenericCommand command(loftili::lib::ByteView(begin, last - begin));
+  if(command) m_commands.push_back(command);
+  return stop != end && *stop == '\n' ? stop - begin + 1 : stop - begin;
+}
+
+// a response to one of our pings; it is only complete once its whole body is
+// here, so the bytes after it are never mistaken for the start of a command.
+int CommandStream::FrameResponse(const char *begin, const char *end) {
+  const char *header_end = Find(begin, end, "\r\n\r\n");
+
+  if(header_end == end)
+    return 0;
+
+  const char *body = header_end + 4;
+  std::string head(begin, header_end - begin);
+  int size = body - begin;
+
+  if(head.size() > 12)
+    m_status = atoi(head.c_str() + 9);
+
+  size_t line = 0;
+  bool chunked = false;
+  long length = 0;
+
+  while((line = head.find("\r\n", line)) != std::string::npos) {
+    const char *field = head.c_str() + line + 2;
+    line += 2;
+
+    if(strncasecmp(field, "content-length:", 15) == 0)
+      length = atol(field + 15);
+    else if(strncasecmp(field, "transfer-encoding:", 18) == 0)
+      chunked = strstr(field, "chunked") != nullptr;
+  }
+
+  if(chunked) {
+    const char *last_chunk = Find(header_end, end, "\r\n0\r\n\r\n");
+    if(last_chunk == end) return 0;
+    size = (last_chunk + 7) - begin;
+  } else {
+    if(end - body < length) return 0;
+    size += length;
+  }
+
+  m_pongs++;
+  return size;
+}
+
+// skips bytes that belong to neither kind of message up to the next one that
+// does, holding back a few in case they start a token that is still arriving.
+int CommandStream::Resync(const char *begin, const char *end) {
+  const char *next = std::min(Find(begin + 1, end, "CMD"), Find(begin + 1, end, "HTTP/"));
+  int skipped = next != end ? next - begin : std::max(0, (int) (end - begin) - 4);
+
+  if(skipped > 0)
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("command stream skipping [{0}] bytes of a strange message from server", skipped);
+
+  return skipped;
 }
 
 void CommandStream::Pop() {
   m_commands.erase(m_commands.begin());
 }
 
-const std::shared_ptr<loftili::net::GenericCommand> CommandStream::Latest() {
+size_t CommandStream::Size() {
+  return m_commands.size();
+}
+
+loftili::net::GenericCommand& CommandStream::Latest() {
   return m_commands.front();
 }
 
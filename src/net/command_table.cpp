@@ -0,0 +1,79 @@
+#include "net/command_table.h"
+
+namespace loftili {
+
+namespace net {
+
+namespace {
+
+loftili::commands::audio::Start start;
+loftili::commands::audio::Stop stop;
+loftili::commands::audio::Skip skip;
+
+// kept in ascending hash order, which the assert below holds it to
+constexpr loftili::net::CommandTable::Entry builtin[] = {
+  { CommandHash("audio:skip"), "audio:skip", &skip },
+  { CommandHash("audio:stop"), "audio:stop", &stop },
+  { CommandHash("audio:start"), "audio:start", &start }
+};
+
+constexpr int builtin_count = sizeof(builtin) / sizeof(builtin[0]);
+
+constexpr bool Ascending(const loftili::net::CommandTable::Entry* entries, int count) {
+  return count < 2 || (entries[0].hash < entries[1].hash && Ascending(entries + 1, count - 1));
+}
+
+static_assert(Ascending(builtin, builtin_count), "builtin commands must be sorted by hash and not collide");
+
+const loftili::net::CommandTable::Entry* Search(const loftili::net::CommandTable::Entry* entries, int count, uint32_t hash) {
+  const loftili::net::CommandTable::Entry* end = entries + count;
+  const loftili::net::CommandTable::Entry* found = std::lower_bound(entries, end, hash,
+    [](const loftili::net::CommandTable::Entry& entry, uint32_t value) { return entry.hash < value; });
+  return found != end && found->hash == hash ? found : 0;
+}
+
+}
+
+uint32_t CommandHash(const loftili::lib::ByteView& name) {
+  uint32_t hash = LOFTILI_COMMAND_HASH_OFFSET;
+
+  for(const char *c = name.begin(); c != name.end(); c++)
+    hash = (hash ^ (uint8_t) *c) * LOFTILI_COMMAND_HASH_PRIME;
+
+  return hash;
+}
+
+// false when the name is taken, when its hash collides with another name, or
+// when there is no room left.
+bool CommandTable::Register(const char *name, loftili::net::Command *command) {
+  uint32_t hash = CommandHash(loftili::lib::ByteView(name, strlen(name)));
+
+  if(m_count >= LOFTILI_COMMAND_TABLE_EXTRA || Search(builtin, builtin_count, hash) || Search(m_extra, m_count, hash))
+    return false;
+
+  int at = m_count++;
+
+  for(; at > 0 && m_extra[at - 1].hash > hash; at--)
+    m_extra[at] = m_extra[at - 1];
+
+  Entry entry = { hash, name, command };
+  m_extra[at] = entry;
+  return true;
+}
+
+loftili::net::Command* CommandTable::Find(const loftili::lib::ByteView& name) {
+  uint32_t hash = CommandHash(name);
+  const Entry* entry = Search(builtin, builtin_count, hash);
+
+  if(entry == 0)
+    entry = Search(m_extra, m_count, hash);
+
+  if(entry == 0 || strlen(entry->name) != name.Size() || memcmp(entry->name, name.Data(), name.Size()) != 0)
+    return 0;
+
+  return entry->command;
+}
+
+}
+
+}
@@ -0,0 +1,90 @@
+#include "net/connection_pool.h"
+
+namespace loftili {
+
+namespace net {
+
+ConnectionPool::ConnectionPool() 
+  : m_max_idle_ms(LOFTILI_POOL_MAX_IDLE_MS), m_max_per_host(LOFTILI_POOL_MAX_PER_HOST), m_hits(0), m_misses(0) {
+}
+
+ConnectionPool::ConnectionPool(int max_idle_ms, size_t max_per_host) 
+  : m_max_idle_ms(max_idle_ms), m_max_per_host(max_per_host), m_hits(0), m_misses(0) {
+}
+
+std::string ConnectionPool::Key(const std::string& host, int port, bool is_ssl) {
+  std::stringstream key;
+  key << (is_ssl ? "https" : "http") << "://" << host << ":" << port;
+  return key.str();
+}
+
+// an idle socket is handed over straight away; a new one is connected on
+// the reactor and handed over once it is ready.
+void ConnectionPool::Acquire(loftili::net::Reactor& reactor, const std::string& host, int port, bool is_ssl, const loftili::net::Deadlines& limits, Acquired acquired) {
+  std::string key = Key(host, port, is_ssl);
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    EvictLocked(Clock::now());
+    std::vector<Entry>& idle = m_idle[key];
+
+    if(idle.size() > 0) {
+      loftili::net::TcpSocket socket = idle.back().socket;
+      idle.pop_back();
+      m_hits++;
+      loftili::lib::metrics.Increment("net.pool.hits");
+      spdlog::get(LOFTILI_SPDLOG_ID)->info("connection pool reusing socket for {0} [hits: {1} misses: {2}]", key, m_hits, m_misses);
+      lock.unlock();
+      acquired(0, socket, true);
+      return;
+    }
+
+    m_misses++;
+  }
+
+  loftili::lib::metrics.Increment("net.pool.misses");
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("connection pool opening new socket for {0} [hits: {1} misses: {2}]", key, m_hits, m_misses);
+  loftili::net::TcpSocket socket(is_ssl);
+  socket.Limit(limits);
+  socket.Connect(reactor, host.c_str(), port, [socket, acquired](int result) {
+    acquired(result < 0 ? result : 0, socket, false);
+  });
+}
+
+void ConnectionPool::Release(const std::string& host, int port, bool is_ssl, loftili::net::TcpSocket& socket) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Clock::time_point now = Clock::now();
+  EvictLocked(now);
+  std::vector<Entry>& idle = m_idle[Key(host, port, is_ssl)];
+
+  if(idle.size() >= m_max_per_host)
+    idle.erase(idle.begin());
+
+  // the deadline belonged to the request that just finished with the socket
+  socket.Expires(loftili::net::Deadline());
+  Entry entry = { socket, now };
+  idle.push_back(entry);
+}
+
+void ConnectionPool::Evict() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  EvictLocked(Clock::now());
+}
+
+void ConnectionPool::EvictLocked(Clock::time_point now) {
+  std::map<std::string, std::vector<Entry> >::iterator it = m_idle.begin();
+
+  for(; it != m_idle.end(); ++it) {
+    std::vector<Entry>& idle = it->second;
+    std::vector<Entry>::iterator entry = idle.begin();
+
+    while(entry != idle.end()) {
+      long idle_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry->idle_since).count();
+      entry = idle_ms > m_max_idle_ms ? idle.erase(entry) : entry + 1;
+    }
+  }
+}
+
+}
+
+}
@@ -0,0 +1,183 @@
+#include "net/connector.h"
+
+namespace loftili {
+
+namespace net {
+
+// connected is told the handle, or the error, on the reactor thread. the
+// deadline covers the name lookup as well as the attempts.
+void Connector::Connect(loftili::net::Reactor& reactor, const std::string& host, int port, const loftili::net::Deadline& deadline, Connected connected) {
+  std::shared_ptr<Race> race(new Race { &reactor, host, port, std::vector<ResolvedAddress>(), 0, std::vector<int>(), -1, -1, false, connected });
+
+  if(!deadline.Never())
+    race->deadline_timer = reactor.Timer(deadline.Remaining(), [race]() {
+      race->deadline_timer = -1;
+      Finish(race, LOFTILI_SOCKET_TIMEOUT);
+    });
+
+  if(loftili::net::resolver.Cached(host, port, race->addresses)) {
+    reactor.Post([race]() { Begin(race); });
+    return;
+  }
+
+  std::thread([race, host, port]() {
+    std::vector<ResolvedAddress> addresses;
+    loftili::net::resolver.Resolve(host, port, addresses);
+
+    race->reactor->Post([race, addresses]() {
+      race->addresses = addresses;
+      Begin(race);
+    });
+  }).detach();
+}
+
+void Connector::Begin(std::shared_ptr<Race> race) {
+  if(race->done)
+    return;
+
+  if(race->addresses.size() == 0) {
+    race->done = true;
+
+    if(race->deadline_timer >= 0)
+      race->reactor->Cancel(race->deadline_timer);
+
+    race->connected(-1);
+    return;
+  }
+
+  Interleave(race->addresses);
+  Launch(race);
+}
+
+// starts the next address that will take an attempt, and gives it a head
+// start before the one after it joins in.
+void Connector::Launch(std::shared_ptr<Race> race) {
+  loftili::net::Reactor& reactor = *race->reactor;
+
+  if(race->attempt_timer >= 0)
+    reactor.Cancel(race->attempt_timer);
+
+  race->attempt_timer = -1;
+
+  while(race->next < race->addresses.size()) {
+    int handle = Start(race->addresses[race->next++]);
+
+    if(handle < 0)
+      continue;
+
+    if(!reactor.Watch(handle, loftili::net::Reactor::EVENT_WRITE, [race, handle](int) { Settle(race, handle); })) {
+      close(handle);
+      continue;
+    }
+
+    race->pending.push_back(handle);
+    break;
+  }
+
+  if(race->pending.size() == 0) {
+    Finish(race, -1);
+    return;
+  }
+
+  if(race->next < race->addresses.size())
+    race->attempt_timer = reactor.Timer(LOFTILI_CONNECT_ATTEMPT_DELAY_MS, [race]() {
+      race->attempt_timer = -1;
+      Launch(race);
+    });
+}
+
+void Connector::Settle(std::shared_ptr<Race> race, int handle) {
+  int error = 0;
+  socklen_t length = sizeof(error);
+  getsockopt(handle, SOL_SOCKET, SO_ERROR, &error, &length);
+
+  race->reactor->Unwatch(handle);
+  race->pending.erase(std::remove(race->pending.begin(), race->pending.end(), handle), race->pending.end());
+
+  if(error == 0) {
+    Finish(race, handle);
+    return;
+  }
+
+  close(handle);
+
+  // a refused attempt lets the next address go right away
+  if(race->next < race->addresses.size() || race->pending.size() == 0)
+    Launch(race);
+}
+
+void Connector::Finish(std::shared_ptr<Race> race, int result) {
+  if(race->done) {
+    if(result >= 0) close(result);
+    return;
+  }
+
+  race->done = true;
+  loftili::net::Reactor& reactor = *race->reactor;
+
+  if(race->attempt_timer >= 0)
+    reactor.Cancel(race->attempt_timer);
+
+  if(race->deadline_timer >= 0)
+    reactor.Cancel(race->deadline_timer);
+
+  for(std::vector<int>::iterator it = race->pending.begin(); it != race->pending.end(); ++it) {
+    reactor.Unwatch(*it);
+    close(*it);
+  }
+
+  race->pending.clear();
+
+  if(result == LOFTILI_SOCKET_TIMEOUT) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("timed out connecting to {0}:{1}", race->host, race->port);
+  } else if(result < 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to connect to any address of {0}:{1}", race->host, race->port);
+    loftili::net::resolver.Forget(race->host, race->port);
+  }
+
+  race->connected(result);
+}
+
+// alternates address families, keeping the resolver's preference order within
+// each, so a broken family costs one attempt delay rather than every address.
+void Connector::Interleave(std::vector<ResolvedAddress>& addresses) {
+  if(addresses.size() < 2)
+    return;
+
+  int first_family = addresses[0].family;
+  std::vector<ResolvedAddress> preferred, other, result;
+
+  for(std::vector<ResolvedAddress>::iterator it = addresses.begin(); it != addresses.end(); ++it)
+    (it->family == first_family ? preferred : other).push_back(*it);
+
+  for(size_t i = 0; i < preferred.size() || i < other.size(); i++) {
+    if(i < preferred.size()) result.push_back(preferred[i]);
+    if(i < other.size()) result.push_back(other[i]);
+  }
+
+  addresses.swap(result);
+}
+
+int Connector::Start(const ResolvedAddress& address) {
+  int handle = socket(address.family, SOCK_STREAM, 0);
+
+  if(handle < 0)
+    return -1;
+
+#if defined(__APPLE__)
+  int on = 1;
+  setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+  fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+
+  if(connect(handle, (const struct sockaddr*) &address.address, address.length) == 0 || errno == EINPROGRESS)
+    return handle;
+
+  close(handle);
+  return -1;
+}
+
+}
+
+}
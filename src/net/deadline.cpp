@@ -0,0 +1,42 @@
+#include "net/deadline.h"
+
+namespace loftili {
+
+namespace net {
+
+const loftili::net::Deadlines default_deadlines = {
+  LOFTILI_TIMEOUT_CONNECT_MS,
+  LOFTILI_TIMEOUT_HANDSHAKE_MS,
+  LOFTILI_TIMEOUT_FIRST_BYTE_MS,
+  LOFTILI_TIMEOUT_IDLE_MS,
+  LOFTILI_TIMEOUT_TOTAL_MS
+};
+
+Deadline::Deadline() : m_never(true) {
+}
+
+Deadline::Deadline(int milliseconds) : m_at(Clock::now() + std::chrono::milliseconds(milliseconds)), m_never(milliseconds <= 0) {
+}
+
+// milliseconds left, ready to hand to poll: -1 waits forever, 0 has expired.
+int Deadline::Remaining() const {
+  if(m_never)
+    return -1;
+
+  long left = std::chrono::duration_cast<std::chrono::milliseconds>(m_at - Clock::now()).count();
+  return (int) std::max(0L, left);
+}
+
+bool Deadline::Expired() const {
+  return !m_never && Clock::now() >= m_at;
+}
+
+Deadline Deadline::Sooner(const Deadline& a, const Deadline& b) {
+  if(a.m_never) return b;
+  if(b.m_never) return a;
+  return a.m_at <= b.m_at ? a : b;
+}
+
+}
+
+}
@@ -7,65 +7,63 @@ namespace net {
 GenericCommand::GenericCommand() : m_cmd(0) {
 }
 
-GenericCommand::GenericCommand(const char* data) {
-  std::string cmd_str = std::string(data);
-  bool is_command = cmd_str.find("CMD", 0, 3) != std::string::npos;
+GenericCommand::GenericCommand(const char* data) : GenericCommand(loftili::lib::ByteView(data, strlen(data))) {
+}
+
+GenericCommand::GenericCommand(const loftili::lib::ByteView& message) : m_cmd(0) {
+  loftili::lib::ByteView name, arguments;
 
-  if(!is_command) {
+  if(!Parse(message, name, arguments)) {
     spdlog::get(LOFTILI_SPDLOG_ID)->warn("generic command unable to parse message");
     return;
   }
 
-  std::string cmd = cmd_str.substr(4);
-  const char *type_break = strchr(cmd.c_str(), ':');
-  int type_length = type_break - cmd.c_str();
+  m_cmd = loftili::net::dispatch.Find(name);
 
-  if(cmd.substr(0, type_length) == "audio") {
-    AudioCommand(cmd);
+  if(!m_cmd) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("ignoring unknown command [{0}]", std::string(name.Data(), name.Size()));
     return;
   }
 
-  return;
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("received command [{0}]", std::string(name.Data(), name.Size()));
+  m_arguments.assign(arguments.Data(), arguments.Size());
 }
 
-void GenericCommand::AudioCommand(std::string cmd) {
-  const int type_length = 5;
-  std::string command_value = cmd.substr(type_length + 1);
+// splits "CMD name arguments" into views of the name and whatever follows it.
+bool GenericCommand::Parse(const loftili::lib::ByteView& message, loftili::lib::ByteView& name, loftili::lib::ByteView& arguments) {
+  if(message.Size() < 4 || strncmp(message.Data(), "CMD ", 4) != 0)
+    return false;
 
-  if(command_value == "stop") {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("received an audio STOP command");
-    m_cmd = new loftili::commands::audio::Stop();
-    return;
-  } 
-  
-  if(command_value == "skip") {
-    spdlog::get(LOFTILI_SPDLOG_ID)->info("received an audio SKIP command");
-    m_cmd = new loftili::commands::audio::Skip();
-    return;
-  }
+  const char *begin = message.begin() + 4, *end = message.end();
+  const char *space = std::find(begin, end, ' ');
 
-  spdlog::get(LOFTILI_SPDLOG_ID)->info("received an audio START command");
-  m_cmd = new loftili::commands::audio::Start();
+  if(std::find(begin, space, ':') == space)
+    return false;
+
+  name = loftili::lib::ByteView(begin, space - begin);
+  arguments = space == end ? loftili::lib::ByteView() : loftili::lib::ByteView(space + 1, end - space - 1);
+  return true;
 }
 
-void GenericCommand::Execute(Engine* eng) {
-  if(!m_cmd) return;
+// true when the bytes spell out a whole "CMD namespace:verb" we understand and
+// nothing more, i.e. there are no arguments that could still be arriving.
+bool GenericCommand::Known(const char *data, int size) {
+  loftili::lib::ByteView name, arguments;
+  return Parse(loftili::lib::ByteView(data, size), name, arguments) && arguments.Empty() && loftili::net::dispatch.Find(name) != 0;
+}
 
-  m_cmd->Execute(eng);
-  delete m_cmd;
-  m_cmd = 0;
+void GenericCommand::Execute(Engine* eng, const std::string& arguments) {
+  if(!m_cmd) return;
+  m_cmd->Execute(eng, arguments);
 }
 
-void GenericCommand::operator()(Engine* eng) {
-  return Execute(eng);
+void GenericCommand::operator()(Engine* eng, const std::string& arguments) {
+  return Execute(eng, arguments);
 }
 
 GenericCommand::operator bool() {
   return m_cmd != 0;
 }
-GenericCommand::~GenericCommand() {
-  if(m_cmd) delete m_cmd;
-}
 
 }
 
@@ -0,0 +1,134 @@
+#include "net/heartbeat.h"
+
+namespace loftili {
+
+namespace net {
+
+Heartbeat::Heartbeat() : m_reactor(0), m_timer(-1), m_quiet(0), m_interval(LOFTILI_HEARTBEAT_MIN_MS), m_ceiling(LOFTILI_HEARTBEAT_MAX_MS), m_steady(0), m_doubted(false) {
+}
+
+// begins watching a freshly subscribed socket; the sender writes one ping,
+// the first listener is told when the link has stopped answering and the
+// second when a ping is late enough to start doubting it.
+void Heartbeat::Start(loftili::net::Reactor& reactor, Sender sender, Listener dead, Listener doubt) {
+  Stop();
+  m_reactor = &reactor;
+  m_sender = sender;
+  m_dead = dead;
+  m_doubt = doubt;
+  m_doubted = false;
+  m_interval = std::min(LOFTILI_HEARTBEAT_MIN_MS, m_ceiling);
+  m_last_activity = Clock::now();
+  m_outstanding.clear();
+  Arm(m_interval);
+}
+
+void Heartbeat::Stop() {
+  if(m_reactor != 0 && m_timer >= 0)
+    m_reactor->Cancel(m_timer);
+
+  m_timer = -1;
+}
+
+// the socket failed; if it had been quiet for a while that is most likely a
+// middlebox forgetting the flow, so stay comfortably below that idle time. a
+// ping that vanished says the flow was gone by the time it was sent.
+void Heartbeat::Lost() {
+  int idle = m_outstanding.size() > 0 ? m_quiet : Since(m_last_activity);
+  Stop();
+  m_outstanding.clear();
+  m_steady = 0;
+
+  if(idle < LOFTILI_HEARTBEAT_MIN_MS)
+    return;
+
+  m_ceiling = std::max(LOFTILI_HEARTBEAT_MIN_MS, std::min(m_ceiling, idle * 3 / 4));
+  loftili::lib::metrics.Set("net.heartbeat.ceiling_ms", m_ceiling);
+  spdlog::get(LOFTILI_SPDLOG_ID)->warn("link dropped after [{0}]ms idle, heartbeat capped at [{1}]ms", idle, m_ceiling);
+}
+
+void Heartbeat::Activity() {
+  m_last_activity = Clock::now();
+}
+
+void Heartbeat::Pong() {
+  m_last_activity = Clock::now();
+
+  if(m_outstanding.size() == 0)
+    return;
+
+  int rtt = Since(m_outstanding.front());
+  m_outstanding.pop_front();
+
+  // the link keeps surviving at the ceiling; whatever capped it may be gone
+  if(m_ceiling < LOFTILI_HEARTBEAT_MAX_MS && m_interval >= m_ceiling && ++m_steady >= LOFTILI_HEARTBEAT_RECOVER_BEATS) {
+    m_steady = 0;
+    m_ceiling = std::min(LOFTILI_HEARTBEAT_MAX_MS, m_ceiling + m_ceiling / 8);
+    loftili::lib::metrics.Set("net.heartbeat.ceiling_ms", m_ceiling);
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("heartbeat steady at its ceiling, raising it to [{0}]ms", m_ceiling);
+  }
+
+  m_interval = std::min(m_ceiling, std::min(LOFTILI_HEARTBEAT_MAX_MS, m_interval * 3 / 2));
+  loftili::lib::metrics.Set("net.heartbeat.rtt_ms", rtt);
+  loftili::lib::metrics.Set("net.heartbeat.interval_ms", m_interval);
+
+  // the timer was waiting out the pong deadline; the next beat is due sooner
+  if(m_outstanding.size() == 0 && m_timer >= 0)
+    Arm(m_interval);
+}
+
+void Heartbeat::Arm(int delay) {
+  if(m_reactor == 0)
+    return;
+
+  if(m_timer >= 0)
+    m_reactor->Cancel(m_timer);
+
+  m_timer = m_reactor->Timer(std::max(0, delay), [this]() {
+    m_timer = -1;
+    Tick();
+  });
+}
+
+void Heartbeat::Tick() {
+  if(m_outstanding.size() > 0 && Since(m_outstanding.front()) >= LOFTILI_HEARTBEAT_PONG_TIMEOUT_MS) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("heartbeat unanswered for [{0}]ms, link is dead", Since(m_outstanding.front()));
+    m_dead();
+    return;
+  }
+
+  if(m_outstanding.size() > 0 && !m_doubted && Since(m_outstanding.front()) >= LOFTILI_HEARTBEAT_DOUBT_MS) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("heartbeat unanswered for [{0}]ms, link is in doubt", Since(m_outstanding.front()));
+    loftili::lib::metrics.Increment("net.heartbeat.doubts");
+    m_doubted = true;
+    if(m_doubt) m_doubt();
+  }
+
+  int idle = Since(m_last_activity);
+
+  if(idle >= m_interval && m_outstanding.size() == 0) {
+    if(!m_sender())
+      return;
+
+    m_quiet = idle;
+    m_doubted = false;
+    m_outstanding.push_back(Clock::now());
+    loftili::lib::metrics.Increment("net.heartbeat.pings");
+    idle = 0;
+  }
+
+  int next = m_interval - idle;
+
+  if(m_outstanding.size() > 0)
+    next = (m_doubted ? LOFTILI_HEARTBEAT_PONG_TIMEOUT_MS : LOFTILI_HEARTBEAT_DOUBT_MS) - Since(m_outstanding.front());
+
+  Arm(next);
+}
+
+int Heartbeat::Since(Clock::time_point then) {
+  return (int) std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - then).count();
+}
+
+}
+
+}
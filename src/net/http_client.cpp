@@ -5,31 +5,54 @@ namespace loftili {
 namespace net {
 
 bool HttpClient::Send(HttpRequest& req) {
-  bool is_ssl = req.Url().Protocol() == "https";
-  TcpSocket socket(is_ssl);
-
+  return Send(req, loftili::net::HttpBodyCallback());
+}
 
-  int port = req.Url().Port() > 0 ? req.Url().Port() : (is_ssl ? 443 : 80);
-  int result = socket.Connect(req.Url().Host().c_str(), port);
+// the sink is called on the reactor thread. false when there was no response,
+// including when the reactor finished before it could carry the request out.
+bool HttpClient::Send(HttpRequest& req, loftili::net::HttpBodyCallback sink) {
+  typedef std::pair<std::shared_ptr<loftili::net::HttpResponse>, bool> Outcome;
+  m_timed_out = false;
 
-  if(result < 0)
+  if(loftili::net::reactor.Inside()) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->critical("refusing to wait for a request to {0} on the reactor thread", req.Url().Host());
     return false;
+  }
 
-  std::string request_string(req);
+  std::shared_ptr< std::promise<Outcome> > outcome(new std::promise<Outcome>());
+  std::future<Outcome> answer = outcome->get_future();
+  loftili::net::HttpRequest request(req);
 
-  result = socket.Write(request_string.c_str(), request_string.size());
+  bool posted = loftili::net::reactor.Post([request, sink, outcome]() {
+    loftili::net::HttpTransfer::Start(request, sink, [outcome](std::shared_ptr<loftili::net::HttpResponse> res, bool timed_out) {
+      outcome->set_value(Outcome(res, timed_out));
+    });
+  });
 
-  if(result < 0) 
+  if(!posted)
     return false;
 
-  if(m_parser << socket)
-    m_responses.push_back(std::shared_ptr<loftili::net::HttpResponse>(new loftili::net::HttpResponse(m_parser.Data())));
+  Outcome result;
+
+  // a reactor that stops with the request in flight drops it, and the
+  // promise along with it
+  try {
+    result = answer.get();
+  } catch(const std::future_error&) {
+    return false;
+  }
+
+  m_timed_out = result.second;
+
+  if(!result.first)
+    return false;
 
-  return m_responses.size() == 1;
+  m_responses.push_back(result.first);
+  return true;
 };
 
 std::shared_ptr<loftili::net::HttpResponse> HttpClient::Latest() {
-  return m_responses.front();
+  return m_responses.back();
 }
 
 }
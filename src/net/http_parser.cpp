@@ -7,6 +7,10 @@ namespace net {
 HttpParser::HttpParser() : m_impl(new loftili::net::HttpParser::Impl) {
 }
 
+HttpParser::HttpParser(HttpBodyCallback sink) : m_impl(new loftili::net::HttpParser::Impl) {
+  m_impl->m_sink = sink;
+}
+
 bool HttpParser::operator<<(loftili::net::TcpSocket& socket) {
   do {
     m_impl->Read(socket);
@@ -15,88 +19,382 @@ bool HttpParser::operator<<(loftili::net::TcpSocket& socket) {
   return m_impl->m_state == loftili::net::HttpParser::Impl::RECEIVING_STATE_FINISHED;
 }
 
-HttpParser::Impl::Impl() : m_size(0), m_state(RECEIVING_STATE_HEADERS) {
-  m_data = (char*) malloc(sizeof(char) * 1);
-  m_data[0] = '\0';
+// reads whatever a non-blocking socket has ready, a few reads at most so one
+// busy download can't hold up the rest of the reactor. true while more of the
+// response is to come; Waiting says whether that is up to the socket, and Due
+// when it should have arrived by.
+bool HttpParser::Receive(loftili::net::TcpSocket& socket) {
+  m_impl->m_waiting = false;
+
+  for(int i = 0; i < LOFTILI_PARSER_READS_PER_WAKE && m_impl->Receiving() && !m_impl->m_waiting; i++)
+    m_impl->Read(socket);
+
+  return m_impl->Receiving();
+}
+
+// the first deadline applies until any of the response arrives. after that
+// each read gets the idle limit, in milliseconds, cut short by the total.
+void HttpParser::Expires(const loftili::net::Deadline& first_byte, const loftili::net::Deadline& total, int idle) {
+  m_impl->m_first_byte = first_byte;
+  m_impl->m_total = total;
+  m_impl->m_idle = idle;
+}
+
+// hands the receive buffer, still nul terminated, to the caller who must free it.
+char* HttpParser::Release() {
+  char *data = m_impl->m_data;
+  m_impl->m_data = 0;
+  m_impl->m_capacity = 0;
+  return data;
+}
+
+HttpParser::Impl::Impl() : m_data(0), m_size(0), m_capacity(0), m_delivered(0), m_scanned(0), 
+  m_header_end(-1), m_body_end(0), m_content_size(0), m_chunk_remaining(0), m_status(0),
+  m_timed_out(false), m_waiting(false), m_idle(0), m_framing(FRAMING_NONE), m_state(RECEIVING_STATE_HEADERS) {
+  if(Reserve(LOFTILI_PARSER_READ_SIZE))
+    m_data[0] = '\0';
 }
 
 HttpParser::Impl::~Impl() {
   free(m_data);
 }
 
+// grows the buffer geometrically so a download costs a constant number of copies
+// per byte; one byte past the requested size is always kept for the terminator.
+// false, with the buffer left as it was, when the memory can't be had.
+bool HttpParser::Impl::Reserve(int size) {
+  if(size + 1 <= m_capacity)
+    return true;
+
+  int capacity = m_capacity > 0 ? m_capacity : LOFTILI_PARSER_READ_SIZE;
+
+  while(capacity < size + 1)
+    capacity *= 2;
+
+  char *data = (char*) realloc(m_data, sizeof(char) * capacity);
+
+  if(data == NULL)
+    return false;
+
+  m_data = data;
+  m_capacity = capacity;
+  return true;
+}
+
 void HttpParser::Impl::Read(loftili::net::TcpSocket& socket) {
-  char buffer[2048];
+  int wanted = LOFTILI_PARSER_READ_SIZE;
+
+  // a body being streamed is read a buffer at a time; one being kept is read
+  // straight into the room reserved for all of it
+  if(m_state == RECEIVING_STATE_BODY && m_framing == FRAMING_LENGTH)
+    wanted = m_content_size - (m_delivered + m_size - m_header_end);
 
-  int received = socket.Read(buffer, 2048);
+  if(m_sink && wanted > LOFTILI_PARSER_READ_SIZE)
+    wanted = LOFTILI_PARSER_READ_SIZE;
 
-  if(received < 0) {
+  if(!Reserve(m_size + wanted)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to grow the response buffer past {0} bytes", m_capacity);
+    m_state = RECEIVING_STATE_ERRORED;
+    return;
+  }
+
+  socket.Expires(Due());
+  int received = socket.Read(&m_data[m_size], wanted);
+
+  if(received == LOFTILI_SOCKET_WOULDBLOCK) {
+    m_waiting = true;
+    return;
+  }
+
+  if(received == LOFTILI_SOCKET_TIMEOUT)
+    m_timed_out = true;
+
+  if(received == 0 && m_framing == FRAMING_CLOSE) {
+    m_state = RECEIVING_STATE_FINISHED;
+    Deliver();
+    return;
+  }
+
+  if(received <= 0) {
     m_state = RECEIVING_STATE_ERRORED;
     return;
   }
 
-  m_data = (char*) realloc(m_data, sizeof(char) * (received + m_size + 1));
-  memcpy(&m_data[m_size], &buffer[0], sizeof(char) * received);
   m_size += received;
   m_data[m_size] = '\0';
   UpdateState();
 }
 
 void HttpParser::Impl::UpdateState() {
-  const char *header_break = strstr(m_data, "\r\n\r\n");
+  if(m_state == RECEIVING_STATE_HEADERS) {
+    // resume the scan a few bytes back so a break split across reads is still found
+    const char *header_break = strstr(&m_data[m_scanned], "\r\n\r\n");
 
-  if(header_break == nullptr)
-    return;
+    if(header_break == nullptr) {
+      m_scanned = m_size > 3 ? m_size - 3 : 0;
+      return;
+    }
 
-  int header_end = header_break - m_data;
+    int header_end = header_break - m_data;
 
-  if(header_end < 15) {
-    m_state = RECEIVING_STATE_ERRORED;
-    return;
+    if(header_end < 15) {
+      m_state = RECEIVING_STATE_ERRORED;
+      return;
+    }
+
+    m_header_end = m_body_end = header_end + 4;
+    ReadHeaders();
+
+    if(m_state == RECEIVING_STATE_ERRORED)
+      return;
   }
 
-  bool headers = m_state == RECEIVING_STATE_HEADERS;
+  if(m_framing == FRAMING_CHUNKED)
+    DecodeChunks();
+  else if(m_state != RECEIVING_STATE_ERRORED)
+    m_body_end = m_size;
 
-  if(headers) {
-    FindContentLength();
+  // a body with no declared length is held to the same limit as one with
+  if(m_delivered + (m_body_end - m_header_end) > LOFTILI_PARSER_MAX_BODY) {
+    m_state = RECEIVING_STATE_ERRORED;
     return;
   }
 
-  if(m_size - (header_end + 4) == m_content_size)
+  if(m_framing == FRAMING_LENGTH && m_delivered + (m_body_end - m_header_end) >= m_content_size)
     m_state = RECEIVING_STATE_FINISHED;
+
+  if(m_framing == FRAMING_NONE)
+    m_state = RECEIVING_STATE_FINISHED;
+
+  Deliver();
 }
 
-void HttpParser::Impl::FindContentLength() {
-  const char *header_break = strstr(m_data, "\r\n\r\n");
+void HttpParser::Impl::ReadHeaders() {
+  const char *line = m_data, 
+             *end = &m_data[m_header_end];
+  bool chunked = false;
+
+  m_status = strchr(m_data, ' ') != nullptr ? atoi(strchr(m_data, ' ') + 1) : 0;
+
+  while(line < end) {
+    const char *line_end = strstr(line, "\r\n");
+
+    if(line_end == nullptr || line_end >= end)
+      break;
+
+    // a length that isn't a plain count, or is too large to buffer, fails the
+    // response rather than being trusted for sizing reads and reservations
+    if(line_end - line > 15 && strncasecmp(line, "content-length:", 15) == 0) {
+      char *length_end;
+      errno = 0;
+      long long length = strtoll(line + 15, &length_end, 10);
+
+      while(length_end < line_end && (*length_end == ' ' || *length_end == '\t'))
+        length_end++;
+
+      if(errno != 0 || length_end == line + 15 || length_end != line_end || length < 0 || length > LOFTILI_PARSER_MAX_BODY) {
+        m_state = RECEIVING_STATE_ERRORED;
+        return;
+      }
+
+      m_content_size = (int) length;
+      m_framing = FRAMING_LENGTH;
+    }
+
+    if(line_end - line > 18 && strncasecmp(line, "transfer-encoding:", 18) == 0) {
+      std::string encoding(line + 18, line_end - line - 18);
+      std::transform(encoding.begin(), encoding.end(), encoding.begin(), ::tolower);
+      chunked = encoding.find("chunked") != std::string::npos;
+    }
+
+    line = line_end + 2;
+  }
+
+  bool bodyless = (m_status >= 100 && m_status < 200) || m_status == 204 || m_status == 304;
+
+  if(bodyless) {
+    m_framing = FRAMING_NONE;
+    return;
+  }
+
+  // chunked framing wins over a content length when a proxy sends both
+  if(chunked) {
+    m_framing = FRAMING_CHUNKED;
+    m_state = RECEIVING_STATE_CHUNK_SIZE;
+    return;
+  }
 
-  if(header_break == nullptr)
+  if(m_framing == FRAMING_LENGTH) {
+    m_state = RECEIVING_STATE_BODY;
+    if(!m_sink && !Reserve(m_header_end + m_content_size))
+      m_state = RECEIVING_STATE_ERRORED;
     return;
+  }
+
+  m_framing = FRAMING_CLOSE;
+  m_state = RECEIVING_STATE_BODY;
+}
 
-  int header_end = header_break - m_data;
-  std::stringstream header_reader(std::string(m_data, header_end));
-  std::string line;
+// decodes chunks in place: payload bytes are moved down to m_body_end so the
+// buffer always holds the headers, the decoded body and any undecoded tail.
+void HttpParser::Impl::DecodeChunks() {
+  int cursor = m_body_end;
 
-  while(std::getline(header_reader, line) && line != "\r") {
-    int split = line.find(':', 0);
+  while(cursor < m_size && Receiving()) {
+    if(m_state == RECEIVING_STATE_CHUNK_DATA) {
+      int available = (int) std::min(m_chunk_remaining, (long) (m_size - cursor));
+
+      if(cursor != m_body_end)
+        memmove(&m_data[m_body_end], &m_data[cursor], available);
+
+      m_body_end += available;
+      cursor += available;
+      m_chunk_remaining -= available;
+
+      if(m_chunk_remaining == 0)
+        m_state = RECEIVING_STATE_CHUNK_END;
 
-    if(split > line.size()  - 2 || split == 0)
       continue;
+    }
+
+    const char *line_end = strstr(&m_data[cursor], "\r\n");
+
+    if(line_end == nullptr)
+      break;
+
+    int line_size = line_end - &m_data[cursor];
 
-    std::string key = line.substr(0, split),
-                val = line.substr(split + 2);
+    if(m_state == RECEIVING_STATE_CHUNK_END) {
+      m_state = line_size == 0 ? RECEIVING_STATE_CHUNK_SIZE : RECEIVING_STATE_ERRORED;
+    } else if(m_state == RECEIVING_STATE_CHUNK_SIZE) {
+      char *size_end;
+      errno = 0;
+      long chunk_size = strtol(&m_data[cursor], &size_end, 16);
+      long decoded = m_delivered + (m_body_end - m_header_end);
 
-    std::transform(key.begin(), key.end(), key.begin(), ::toupper);
-    if(key.find("CONTENT-LENGTH") == 0 && key.size() == 14) {
-      m_content_size = std::stoi(val);
-      m_state = RECEIVING_STATE_BODY;
-      UpdateState();
+      if(errno != 0 || size_end == &m_data[cursor] || chunk_size < 0 || chunk_size > LOFTILI_PARSER_MAX_BODY - decoded) {
+        m_state = RECEIVING_STATE_ERRORED;
+        break;
+      }
+
+      m_chunk_remaining = chunk_size;
+      m_state = chunk_size == 0 ? RECEIVING_STATE_CHUNK_TRAILER : RECEIVING_STATE_CHUNK_DATA;
+    } else if(m_state == RECEIVING_STATE_CHUNK_TRAILER && line_size == 0) {
+      m_state = RECEIVING_STATE_FINISHED;
     }
+
+    cursor += line_size + 2;
+  }
+
+  int pending = m_size - cursor;
+
+  if(cursor != m_body_end && pending > 0)
+    memmove(&m_data[m_body_end], &m_data[cursor], pending);
+
+  m_size = m_body_end + (pending > 0 ? pending : 0);
+  m_data[m_size] = '\0';
+
+  if(m_state == RECEIVING_STATE_FINISHED) {
+    m_size = m_body_end;
+    m_data[m_size] = '\0';
   }
 }
 
+// hands decoded bytes to the sink and drops them from the buffer so a streamed
+// download only ever holds one read worth of body. anything but a 200 is kept
+// whole so callers can still inspect it, and never reaches the sink.
+void HttpParser::Impl::Deliver() {
+  if(!m_sink || m_status != 200 || m_body_end <= m_header_end)
+    return;
+
+  int decoded = m_body_end - m_header_end;
+
+  if(!m_sink(&m_data[m_header_end], decoded)) {
+    m_state = RECEIVING_STATE_ERRORED;
+    return;
+  }
+
+  int pending = m_size - m_body_end;
+
+  if(pending > 0)
+    memmove(&m_data[m_header_end], &m_data[m_body_end], pending);
+
+  m_delivered += decoded;
+  m_body_end = m_header_end;
+  m_size = m_header_end + pending;
+  m_data[m_size] = '\0';
+}
+
+// the point the next read gives up by, from now
+loftili::net::Deadline HttpParser::Impl::Due() {
+  bool started = m_size > 0 || m_delivered > 0;
+  return started ? loftili::net::Deadline::Sooner(loftili::net::Deadline(m_idle), m_total) : m_first_byte;
+}
+
 bool HttpParser::Impl::Receiving() {
   return m_state != RECEIVING_STATE_ERRORED && m_state != RECEIVING_STATE_FINISHED;
 }
 
+namespace {
+
+std::string Response(long size, bool chunked) {
+  std::stringstream head;
+  head << "HTTP/1.1 200 OK\r\nContent-Type: audio/mpeg\r\n";
+
+  if(!chunked) {
+    head << "Content-Length: " << size << "\r\n\r\n";
+    return head.str() + std::string(size, 'a');
+  }
+
+  head << "Transfer-Encoding: chunked\r\n\r\n";
+  std::string response = head.str();
+
+  for(long sent = 0; sent < size; sent += LOFTILI_PARSER_READ_SIZE) {
+    long part = std::min((long) LOFTILI_PARSER_READ_SIZE, size - sent);
+    char line[32];
+    snprintf(line, sizeof(line), "%lx\r\n", part);
+    response += line + std::string(part, 'a') + "\r\n";
+  }
+
+  return response + "0\r\n\r\n";
+}
+
+}
+
+// if parsing is linear in the body size, the time per byte stays flat from
+// the smallest response to the largest
+int HttpParser::Benchmark() {
+  printf("%-8s %12s %14s %10s\n", "framing", "body bytes", "bytes/s", "ns/byte");
+
+  for(int chunked = 0; chunked < 2; chunked++) {
+    for(long size = 1024; size <= 100L * 1024 * 1024; size *= 10) {
+      std::string response = Response(size, chunked);
+      loftili::net::MemorySocket socket(response);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), now = start;
+      long passes = 0;
+      bool ok = true;
+
+      while(ok && std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() < LOFTILI_PARSER_BENCHMARK_MS) {
+        loftili::net::HttpParser parser;
+        socket.Rewind();
+        ok = parser << socket;
+        passes++;
+        now = std::chrono::steady_clock::now();
+      }
+
+      double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(now - start).count();
+      double rate = (double) size * passes / seconds;
+
+      if(ok)
+        printf("%-8s %12ld %14.0f %10.3f\n", chunked ? "chunked" : "length", size, rate, 1e9 / rate);
+      else
+        printf("%-8s %12ld %14s %10s\n", chunked ? "chunked" : "length", size, "failed", "-");
+    }
+  }
+
+  return 0;
+}
+
 }
 
 }
@@ -4,40 +4,118 @@ namespace loftili {
 
 namespace net {
 
+static const char request_tail[] = "X-Powered-By: loftili core\r\n\r\n";
+
 HttpRequest::HttpRequest(const loftili::net::Url& url) 
-  : m_url(url), m_method("GET") {
+  : m_url(url), m_method("GET"), m_limits(loftili::net::default_deadlines), m_rendered(false), m_header_count(0) {
 }
 
 HttpRequest::HttpRequest(const loftili::net::Url& url, std::string method) 
-  : m_url(url), m_method(method) {
+  : m_url(url), m_method(method), m_limits(loftili::net::default_deadlines), m_rendered(false), m_header_count(0) {
 }
 
 HttpRequest::HttpRequest(const loftili::net::Url& url, std::string method, std::string body) 
-  : m_url(url), m_method(method), m_body(body) {
+  : m_url(url), m_method(method), m_body(std::move(body)), m_limits(loftili::net::default_deadlines), m_rendered(false), m_header_count(0) {
 }
 
-HttpRequest::operator std::string() {
-  std::stringstream req_str;
-  req_str << m_method << " " << m_url.Path() << " HTTP/1.1\n";
-  req_str << "Host: " << m_url.Host() << "\n";
-  req_str << "Content-Length: " << m_body.size() << "\n";
-
-  typedef std::pair<std::string, std::string> header_pairs;
-  std::vector<header_pairs>::iterator it = m_headers.begin();
-  for(; it != m_headers.end(); ++it) {
-    req_str << std::get<0, std::string, std::string>(*it) << ": " << std::get<1, std::string, std::string>(*it) << "\n";
+// the request line, host and length only change with the url and body, so they
+// are rendered once into m_head and reused on every subsequent write.
+void HttpRequest::Render() {
+  if(m_rendered)
+    return;
+
+  std::string path = m_url.Path();
+  std::string host = m_url.Host();
+  std::string length = std::to_string(m_body.size());
+
+  m_head.clear();
+  m_head.reserve(m_method.size() + path.size() + host.size() + length.size() + 48);
+  m_head.append(m_method).append(" ").append(path.size() > 0 ? path : "/").append(" HTTP/1.1\r\n");
+  m_head.append("Host: ").append(host).append("\r\n");
+  m_head.append("Content-Length: ").append(length).append("\r\n");
+  m_rendered = true;
+}
+
+// points the buffers at the pieces of the request, in order, without copying
+// them. a request with more header blocks than there are buffers is copied
+// once into a single one instead, so callers always get something to send.
+int HttpRequest::Buffers(struct iovec *buffers, int max) {
+  Render();
+  int count = 0;
+
+  if(max < 1)
+    return -1;
+
+  if(max < (int) m_blocks.size() + 4) {
+    m_flat.clear();
+    m_flat.append(m_head).append(m_headers);
+
+    for(auto& block : m_blocks)
+      m_flat.append(*block);
+
+    m_flat.append(request_tail).append(m_body);
+    buffers[0].iov_base = (void*) m_flat.data();
+    buffers[0].iov_len = m_flat.size();
+    return 1;
+  }
+
+  buffers[count].iov_base = (void*) m_head.data();
+  buffers[count++].iov_len = m_head.size();
+
+  if(m_headers.size() > 0) {
+    buffers[count].iov_base = (void*) m_headers.data();
+    buffers[count++].iov_len = m_headers.size();
+  }
+
+  std::vector<HttpHeaderBlock>::iterator it = m_blocks.begin();
+  for(; it != m_blocks.end(); ++it) {
+    buffers[count].iov_base = (void*) (*it)->data();
+    buffers[count++].iov_len = (*it)->size();
   }
 
-  req_str << "X-Powered-By: loftili core";
+  buffers[count].iov_base = (void*) request_tail;
+  buffers[count++].iov_len = sizeof(request_tail) - 1;
 
-  req_str << "\r\n\r\n";
-  req_str << m_body;
-  return req_str.str();
+  if(m_body.size() > 0) {
+    buffers[count].iov_base = (void*) m_body.data();
+    buffers[count++].iov_len = m_body.size();
+  }
+
+  return count;
+}
+
+size_t HttpRequest::Size() {
+  struct iovec buffers[LOFTILI_REQUEST_MAX_BUFFERS];
+  int count = Buffers(buffers, LOFTILI_REQUEST_MAX_BUFFERS);
+  size_t size = 0;
+
+  for(int i = 0; i < count; i++)
+    size += buffers[i].iov_len;
+
+  return size;
+}
+
+HttpRequest::operator std::string() {
+  struct iovec buffers[LOFTILI_REQUEST_MAX_BUFFERS];
+  int count = Buffers(buffers, LOFTILI_REQUEST_MAX_BUFFERS);
+  std::string req_str;
+
+  for(int i = 0; i < count; i++)
+    req_str.append((const char*) buffers[i].iov_base, buffers[i].iov_len);
+
+  return req_str;
 }
 
 int HttpRequest::Header(std::string key, std::string val) {
-  m_headers.push_back(std::make_pair(key, val));
-  return m_headers.size();
+  m_headers.append(key).append(": ").append(val).append("\r\n");
+  return ++m_header_count;
+}
+
+int HttpRequest::Header(HttpHeaderBlock block) {
+  if(block)
+    m_blocks.push_back(block);
+
+  return ++m_header_count;
 }
 
 }
@@ -4,12 +4,43 @@ namespace loftili {
 
 namespace net {
 
-HttpResponse::HttpResponse(const char* data) {
+HttpResponse::HttpResponse() : m_data(0), m_body_start(0), m_body_size(0), m_status(0) {
+}
+
+HttpResponse::HttpResponse(HttpResponse&& other) 
+  : m_headers(std::move(other.m_headers)), m_data(other.m_data), m_body_start(other.m_body_start), 
+  m_body_size(other.m_body_size), m_status(other.m_status) {
+  other.m_data = 0;
+  other.m_body_size = 0;
+}
+
+HttpResponse& HttpResponse::operator=(HttpResponse&& other) {
+  if(this == &other)
+    return *this;
+
+  free(m_data);
+  m_headers = std::move(other.m_headers);
+  m_data = other.m_data;
+  m_body_start = other.m_body_start;
+  m_body_size = other.m_body_size;
+  m_status = other.m_status;
+  other.m_data = 0;
+  other.m_body_size = 0;
+  return *this;
+}
+
+HttpResponse::~HttpResponse() {
+  free(m_data);
+}
+
+HttpResponse::HttpResponse(char* data, int size) : m_data(data), m_status(0) {
   const char *header_break = strstr(data, "\r\n\r\n");
   int head_size = header_break - data,
-      content_length = -1,
       line_number = 0;
 
+  m_body_start = head_size + 4;
+  m_body_size = size - m_body_start;
+
   std::stringstream header_reader(std::string(data, head_size));
   std::string line;
 
@@ -31,18 +62,30 @@ HttpResponse::HttpResponse(const char* data) {
     std::string key = line.substr(0, split),
                 val = line.substr(split + 2);
 
+    if(val.size() > 0 && val[val.size() - 1] == '\r')
+      val.erase(val.size() - 1);
+
     std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+    m_headers.push_back(std::make_pair(key, val));
+  }
+}
 
-    if(key == "CONTENT-LENGTH")
-      content_length = std::stoi(val);
+std::string HttpResponse::Header(std::string key) {
+  std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+  std::vector< std::pair<std::string, std::string> >::iterator it = m_headers.begin();
 
-    m_headers.push_back(std::make_pair(key, val));
+  for(; it != m_headers.end(); ++it) {
+    if(std::get<0>(*it) == key) 
+      return std::get<1>(*it);
   }
 
-  for(int i = 0; i < content_length; i++)
-    m_body.push_back(data[head_size + 4 + i]);
+  return "";
+}
 
-  m_body.push_back('\0');
+bool HttpResponse::KeepAlive() {
+  std::string connection = Header("Connection");
+  std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+  return connection.find("close") == std::string::npos;
 }
 
 }
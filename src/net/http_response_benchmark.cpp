@@ -0,0 +1,75 @@
+#include "net/http_response_benchmark.h"
+
+namespace loftili {
+
+namespace net {
+
+namespace {
+
+long PeakResident() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss * 1024L;
+}
+
+// runs in a process of its own, so the high water mark it reads belongs to
+// this one download alone. the response is in memory before the mark is
+// taken; what the mark rises by afterwards is what the download cost.
+void Measure(long size, bool streamed) {
+  std::stringstream head;
+  head << "HTTP/1.1 200 OK\r\nContent-Length: " << size << "\r\n\r\n";
+  std::string response = head.str();
+  response.append(size, 'a');
+  loftili::net::MemorySocket socket(response);
+  long checksum = 0, before = PeakResident();
+  bool ok;
+
+  if(streamed) {
+    loftili::net::HttpParser parser([&checksum](const char* data, int count) { checksum += data[count - 1]; return true; });
+    ok = parser << socket;
+  } else {
+    loftili::net::HttpParser parser;
+    ok = parser << socket;
+    int received = parser.Size();
+    loftili::net::HttpResponse result(parser.Release(), received);
+    loftili::lib::ByteView body = result.Body();
+    checksum += body.Size() > 0 ? body.Data()[body.Size() - 1] : 0;
+  }
+
+  long used = PeakResident() - before;
+
+  if(ok && checksum != 0)
+    printf("%-8s %12ld %16ld %10.2f\n", streamed ? "streamed" : "whole", size, used, (double) used / size);
+  else
+    printf("%-8s %12ld %16s %10s\n", streamed ? "streamed" : "whole", size, "failed", "-");
+}
+
+}
+
+// a whole response should cost one body sized buffer, handed from the parser
+// to the response without a copy; a streamed one should cost next to nothing.
+int HttpResponse::Benchmark() {
+  printf("%-8s %12s %16s %10s\n", "delivery", "body bytes", "peak extra bytes", "buffers");
+
+  for(int streamed = 0; streamed < 2; streamed++) {
+    for(long size = 1024L * 1024; size <= 100L * 1024 * 1024; size *= 10) {
+      fflush(stdout);
+      pid_t child = fork();
+
+      if(child == 0) {
+        Measure(size, streamed);
+        fflush(stdout);
+        _exit(0);
+      }
+
+      if(child > 0)
+        waitpid(child, NULL, 0);
+    }
+  }
+
+  return 0;
+}
+
+}
+
+}
@@ -0,0 +1,205 @@
+#include "net/http_transfer.h"
+
+namespace loftili {
+
+namespace net {
+
+HttpTransfer::HttpTransfer(const loftili::net::HttpRequest& request, loftili::net::HttpBodyCallback sink, loftili::net::HttpResponseCallback done)
+  : m_request(request), m_sink(sink), m_done(done), m_port(0), m_ssl(false), m_sent(0), m_socket(impl::Derived()),
+  m_watched(-1), m_timer(-1), m_attempts(0), m_reused(false), m_timed_out(false), m_finished(false) {
+  m_ssl = m_request.Url().Protocol() == "https";
+  m_port = m_request.Url().Port() > 0 ? m_request.Url().Port() : (m_ssl ? 443 : 80);
+  m_host = m_request.Url().Host();
+  m_data = m_request;
+}
+
+// done is only ever told from a later turn of the loop, never from in here
+std::shared_ptr<HttpTransfer> HttpTransfer::Start(const loftili::net::HttpRequest& request, loftili::net::HttpBodyCallback sink, loftili::net::HttpResponseCallback done) {
+  std::shared_ptr<HttpTransfer> transfer(new HttpTransfer(request, sink, done));
+  loftili::net::reactor.Post([transfer]() { transfer->Acquire(); });
+  return transfer;
+}
+
+// ends the request early, telling done it failed.
+void HttpTransfer::Cancel() {
+  Finish(std::shared_ptr<loftili::net::HttpResponse>());
+}
+
+void HttpTransfer::Acquire() {
+  if(m_finished)
+    return;
+
+  if(m_data.size() == 0) {
+    Finish(std::shared_ptr<loftili::net::HttpResponse>());
+    return;
+  }
+
+  m_attempts++;
+  m_sent = 0;
+  m_parser.reset(new loftili::net::HttpParser(m_sink));
+  std::shared_ptr<HttpTransfer> self = shared_from_this();
+
+  loftili::net::connections.Acquire(loftili::net::reactor, m_host, m_port, m_ssl, m_request.Limits(), [self](int result, loftili::net::TcpSocket socket, bool reused) {
+    self->Acquired(result, socket, reused);
+  });
+}
+
+void HttpTransfer::Acquired(int result, loftili::net::TcpSocket socket, bool reused) {
+  if(m_finished)
+    return;
+
+  if(result < 0) {
+    m_timed_out = result == LOFTILI_SOCKET_TIMEOUT;
+    Finish(std::shared_ptr<loftili::net::HttpResponse>());
+    return;
+  }
+
+  m_socket = socket;
+  m_reused = reused;
+  m_socket.Blocking(false);
+
+  // sending counts towards the first byte; the total runs from here as well
+  const loftili::net::Deadlines& limits = m_request.Limits();
+  loftili::net::Deadline total(limits.total);
+  m_parser->Expires(loftili::net::Deadline::Sooner(loftili::net::Deadline(limits.first_byte), total), total, limits.idle);
+  Arm(m_parser->Due());
+  Send();
+}
+
+void HttpTransfer::Ready() {
+  if(m_finished)
+    return;
+
+  if(m_sent < m_data.size())
+    Send();
+  else
+    Receive();
+}
+
+void HttpTransfer::Send() {
+  while(m_sent < m_data.size()) {
+    int result = m_socket.Write(m_data.data() + m_sent, m_data.size() - m_sent);
+
+    if(result == LOFTILI_SOCKET_WOULDBLOCK) {
+      Watch(loftili::net::Reactor::EVENT_WRITE);
+      return;
+    }
+
+    if(result <= 0) {
+      Failed();
+      return;
+    }
+
+    m_sent += result;
+  }
+
+  Watch(loftili::net::Reactor::EVENT_READ);
+}
+
+void HttpTransfer::Receive() {
+  if(m_parser->Receive(m_socket)) {
+    Arm(m_parser->Due());
+
+    // the parser stopped short of what the socket has; tls may be holding
+    // the rest where readiness won't show it, so pick it up next turn
+    if(!m_parser->Waiting()) {
+      std::shared_ptr<HttpTransfer> self = shared_from_this();
+      loftili::net::reactor.Post([self]() { self->Ready(); });
+    }
+
+    return;
+  }
+
+  if(!m_parser->Finished()) {
+    Failed();
+    return;
+  }
+
+  int received = m_parser->Size();
+  std::shared_ptr<loftili::net::HttpResponse> res(new loftili::net::HttpResponse(m_parser->Release(), received));
+  Unwatch();
+
+  if(res->KeepAlive() && m_parser->Reusable())
+    loftili::net::connections.Release(m_host, m_port, m_ssl, m_socket);
+
+  Finish(res);
+}
+
+// a pooled socket may have been closed by the server while it sat idle; if
+// nothing at all came back on it, the request is tried again on another.
+void HttpTransfer::Failed() {
+  bool silent = m_parser->Size() == 0 && m_parser->Delivered() == 0;
+
+  if(m_reused && silent && m_attempts < 2) {
+    Unwatch();
+    m_socket = loftili::net::TcpSocket(impl::Derived());
+    Acquire();
+    return;
+  }
+
+  Finish(std::shared_ptr<loftili::net::HttpResponse>());
+}
+
+void HttpTransfer::Finish(std::shared_ptr<loftili::net::HttpResponse> res) {
+  if(m_finished)
+    return;
+
+  m_finished = true;
+  Unwatch();
+
+  if(m_timer >= 0)
+    loftili::net::reactor.Cancel(m_timer);
+
+  m_timer = -1;
+  m_socket = loftili::net::TcpSocket(impl::Derived());
+  m_parser.reset();
+  m_sink = loftili::net::HttpBodyCallback();
+
+  loftili::net::HttpResponseCallback done;
+  done.swap(m_done);
+
+  if(done)
+    done(res, m_timed_out);
+}
+
+void HttpTransfer::Watch(int events) {
+  std::shared_ptr<HttpTransfer> self = shared_from_this();
+  m_watched = m_socket.Handle();
+
+  if(!loftili::net::reactor.Watch(m_watched, events, [self](int) { self->Ready(); })) {
+    m_watched = -1;
+    Failed();
+  }
+}
+
+void HttpTransfer::Unwatch() {
+  if(m_watched >= 0)
+    loftili::net::reactor.Unwatch(m_watched);
+
+  m_watched = -1;
+}
+
+// a timeout has used up the request's time, and trying again would start it
+// over with a fresh set of deadlines, so it is never retried
+void HttpTransfer::Arm(const loftili::net::Deadline& deadline) {
+  if(m_timer >= 0)
+    loftili::net::reactor.Cancel(m_timer);
+
+  m_timer = -1;
+
+  if(deadline.Never())
+    return;
+
+  std::shared_ptr<HttpTransfer> self = shared_from_this();
+
+  m_timer = loftili::net::reactor.Timer(deadline.Remaining(), [self]() {
+    self->m_timer = -1;
+    self->m_timed_out = true;
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("request to {0}:{1} timed out", self->m_host, self->m_port);
+    self->Finish(std::shared_ptr<loftili::net::HttpResponse>());
+  });
+}
+
+}
+
+}
@@ -0,0 +1,16 @@
+#include "net/memory_socket.h"
+
+namespace loftili {
+
+namespace net {
+
+int MemorySocket::Read(char* data, int size) {
+  size_t count = std::min(std::min((size_t) size, (size_t) LOFTILI_MEMORY_SOCKET_READ), m_data.size() - m_offset);
+  memcpy(data, m_data.data() + m_offset, count);
+  m_offset += count;
+  return (int) count;
+}
+
+}
+
+}
@@ -0,0 +1,265 @@
+#include "net/reactor.h"
+
+namespace loftili {
+
+namespace net {
+
+Reactor::Reactor() : m_next_timer(1), m_poller(-1), m_running(false), m_finished(false) {
+  if(pipe(m_wake) == 0) {
+    fcntl(m_wake[0], F_SETFL, fcntl(m_wake[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(m_wake[1], F_SETFL, fcntl(m_wake[1], F_GETFL, 0) | O_NONBLOCK);
+  } else {
+    m_wake[0] = m_wake[1] = -1;
+  }
+
+#if LOFTILI_REACTOR_EPOLL
+  m_poller = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event wake;
+  memset(&wake, 0, sizeof(wake));
+  wake.events = EPOLLIN;
+  wake.data.fd = m_wake[0];
+  epoll_ctl(m_poller, EPOLL_CTL_ADD, m_wake[0], &wake);
+#endif
+}
+
+Reactor::~Reactor() {
+  if(m_poller >= 0) close(m_poller);
+  if(m_wake[0] >= 0) close(m_wake[0]);
+  if(m_wake[1] >= 0) close(m_wake[1]);
+}
+
+bool Reactor::Watch(int handle, int events, IoCallback callback) {
+  if(handle < 0)
+    return false;
+
+  Watcher watcher = { events, callback };
+  bool existing = m_watchers.find(handle) != m_watchers.end();
+  m_watchers[handle] = watcher;
+
+#if LOFTILI_REACTOR_EPOLL
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = (events & EVENT_READ ? EPOLLIN : 0) | (events & EVENT_WRITE ? EPOLLOUT : 0);
+  event.data.fd = handle;
+
+  // a handle closed without being unwatched has already left the epoll set,
+  // so a new socket given the same number has to be added afresh
+  int result = epoll_ctl(m_poller, existing ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, handle, &event);
+
+  if(result < 0 && existing && errno == ENOENT)
+    result = epoll_ctl(m_poller, EPOLL_CTL_ADD, handle, &event);
+
+  if(result < 0) {
+    m_watchers.erase(handle);
+    return false;
+  }
+#endif
+
+  return true;
+}
+
+bool Reactor::Modify(int handle, int events) {
+  std::map<int, Watcher>::iterator it = m_watchers.find(handle);
+
+  if(it == m_watchers.end())
+    return false;
+
+  return Watch(handle, events, it->second.callback);
+}
+
+void Reactor::Unwatch(int handle) {
+  if(m_watchers.erase(handle) == 0)
+    return;
+
+#if LOFTILI_REACTOR_EPOLL
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  epoll_ctl(m_poller, EPOLL_CTL_DEL, handle, &event);
+#endif
+}
+
+int Reactor::Timer(int delay_ms, Task task) {
+  return Timer(delay_ms, task, 0);
+}
+
+// schedules a task after delay_ms, then every repeat_ms if that is positive
+int Reactor::Timer(int delay_ms, Task task, int repeat_ms) {
+  TimerEntry entry = { Clock::now() + std::chrono::milliseconds(delay_ms), repeat_ms, task };
+  int id = m_next_timer++;
+  m_timers[id] = entry;
+  return id;
+}
+
+void Reactor::Cancel(int id) {
+  m_timers.erase(id);
+}
+
+// false once the loop has finished for good; the task will never run.
+bool Reactor::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(m_task_mutex);
+
+    if(m_finished)
+      return false;
+
+    m_tasks.push_back(task);
+  }
+
+  Wake();
+  return true;
+}
+
+bool Reactor::Inside() {
+  return m_running && std::this_thread::get_id() == m_thread;
+}
+
+void Reactor::Stop() {
+  Post([this]() { m_running = false; });
+}
+
+void Reactor::Wake() {
+  char byte = 1;
+  if(m_wake[1] >= 0 && write(m_wake[1], &byte, 1) < 0 && errno != EAGAIN)
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("reactor unable to wake event loop");
+}
+
+// fires every due timer and returns how long the loop may sleep until the
+// next one is due, or -1 when there are none.
+int Reactor::RunTimers() {
+  Clock::time_point now = Clock::now();
+  std::vector<int> due;
+
+  for(std::map<int, TimerEntry>::iterator it = m_timers.begin(); it != m_timers.end(); ++it) {
+    if(it->second.due <= now)
+      due.push_back(it->first);
+  }
+
+  for(std::vector<int>::iterator id = due.begin(); id != due.end(); ++id) {
+    std::map<int, TimerEntry>::iterator it = m_timers.find(*id);
+
+    // an earlier timer in this pass may have cancelled this one
+    if(it == m_timers.end())
+      continue;
+
+    Task task = it->second.task;
+
+    if(it->second.repeat_ms > 0)
+      it->second.due = now + std::chrono::milliseconds(it->second.repeat_ms);
+    else
+      m_timers.erase(it);
+
+    task();
+  }
+
+  if(m_timers.size() == 0)
+    return -1;
+
+  Clock::time_point next = m_timers.begin()->second.due;
+
+  for(std::map<int, TimerEntry>::iterator it = m_timers.begin(); it != m_timers.end(); ++it)
+    next = std::min(next, it->second.due);
+
+  long wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+  return wait < 0 ? 0 : (int) wait + 1;
+}
+
+void Reactor::RunTasks() {
+  char drain[64];
+  while(m_wake[0] >= 0 && read(m_wake[0], drain, sizeof(drain)) > 0);
+
+  std::vector<Task> tasks;
+
+  {
+    std::lock_guard<std::mutex> lock(m_task_mutex);
+    tasks.swap(m_tasks);
+  }
+
+  for(std::vector<Task>::iterator it = tasks.begin(); it != tasks.end(); ++it)
+    (*it)();
+}
+
+void Reactor::Run() {
+  m_thread = std::this_thread::get_id();
+  m_running = true;
+
+  while(m_running) {
+    RunTasks();
+
+    if(!m_running)
+      break;
+
+    int timeout = RunTimers();
+    std::vector<std::pair<int, int> > ready;
+
+#if LOFTILI_REACTOR_EPOLL
+    struct epoll_event events[LOFTILI_REACTOR_MAX_EVENTS];
+    int count = epoll_wait(m_poller, events, LOFTILI_REACTOR_MAX_EVENTS, timeout);
+
+    for(int i = 0; i < count; i++) {
+      int mask = (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP) ? EVENT_READ : 0) 
+        | (events[i].events & EPOLLOUT ? EVENT_WRITE : 0);
+
+      int handle = events[i].data.fd;
+
+      if(handle != m_wake[0])
+        ready.push_back(std::make_pair(handle, mask));
+    }
+#else
+    std::vector<struct pollfd> handles;
+    struct pollfd wake = { m_wake[0], POLLIN, 0 };
+    handles.push_back(wake);
+
+    for(std::map<int, Watcher>::iterator it = m_watchers.begin(); it != m_watchers.end(); ++it) {
+      struct pollfd handle = { it->first, (short) ((it->second.events & EVENT_READ ? POLLIN : 0) | (it->second.events & EVENT_WRITE ? POLLOUT : 0)), 0 };
+      handles.push_back(handle);
+    }
+
+    int count = poll(handles.data(), handles.size(), timeout);
+
+    for(size_t i = 1; count > 0 && i < handles.size(); i++) {
+      int mask = (handles[i].revents & (POLLIN | POLLERR | POLLHUP) ? EVENT_READ : 0) 
+        | (handles[i].revents & POLLOUT ? EVENT_WRITE : 0);
+
+      if(mask != 0)
+        ready.push_back(std::make_pair(handles[i].fd, mask));
+    }
+#endif
+
+    if(count < 0 && errno != EINTR) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->critical("reactor failed waiting for events: {0}", strerror(errno));
+      break;
+    }
+
+    for(std::vector<std::pair<int, int> >::iterator it = ready.begin(); it != ready.end(); ++it) {
+      std::map<int, Watcher>::iterator watcher = m_watchers.find(it->first);
+
+      // a previous callback in this batch may have stopped watching the handle
+      if(watcher == m_watchers.end())
+        continue;
+
+      IoCallback callback = watcher->second.callback;
+      callback(it->second);
+    }
+  }
+
+  m_running = false;
+
+  // whatever was still in flight is dropped along with the callbacks holding
+  // on to it, which lets anyone waiting for an answer know none is coming
+  std::vector<Task> tasks;
+  std::map<int, Watcher> watchers;
+  std::map<int, TimerEntry> timers;
+
+  {
+    std::lock_guard<std::mutex> lock(m_task_mutex);
+    m_finished = true;
+    tasks.swap(m_tasks);
+  }
+
+  watchers.swap(m_watchers);
+  timers.swap(m_timers);
+}
+
+}
+
+}
@@ -0,0 +1,114 @@
+#include "net/reconnect_policy.h"
+
+namespace loftili {
+
+namespace net {
+
+ReconnectPolicy::ReconnectPolicy() : m_backoff(LOFTILI_RECONNECT_BASE_MS, LOFTILI_RECONNECT_CAP_MS), m_lost(false), 
+  m_reactor(0), m_standby(impl::Derived()), m_pending(false), m_wanted(false), m_expiry(-1) {
+}
+
+// only the first loss of an outage starts the clock for time-to-resubscribe
+void ReconnectPolicy::Lost() {
+  if(m_lost)
+    return;
+
+  m_lost = true;
+  m_lost_at = Clock::now();
+}
+
+// milliseconds to wait before the next attempt; the first one is immediate
+int ReconnectPolicy::Next() {
+  if(m_backoff.Attempts() == 0) {
+    m_backoff.Next();
+    return 0;
+  }
+
+  return m_backoff.Next();
+}
+
+void ReconnectPolicy::Recovered() {
+  if(m_lost) {
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_lost_at).count();
+    loftili::lib::metrics.Set("net.engine.resubscribe_ms", elapsed);
+    loftili::lib::metrics.Increment("net.engine.resubscribes");
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("resubscribed [{0}]ms after losing the command stream", elapsed);
+  }
+
+  m_lost = false;
+  m_backoff.Reset();
+}
+
+// connects a standby on the reactor for a primary that is in doubt. one
+// already connected or being connected is left alone.
+void ReconnectPolicy::Prepare(loftili::net::Reactor& reactor, const std::string& host, int port, bool is_ssl) {
+  m_wanted = true;
+
+  if(m_pending || m_standby.Handle() >= 0)
+    return;
+
+  m_reactor = &reactor;
+  m_pending = true;
+  loftili::net::TcpSocket socket(is_ssl);
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("command stream in doubt, connecting a standby");
+
+  socket.Connect(reactor, host.c_str(), port, [this, socket](int result) {
+    m_pending = false;
+
+    // the primary answered again while this was connecting
+    if(result < 0 || !m_wanted)
+      return;
+
+    Discard();
+    m_standby = socket;
+    m_standby_since = Clock::now();
+    m_expiry = m_reactor->Timer(LOFTILI_RECONNECT_STANDBY_MAX_MS, [this]() {
+      m_expiry = -1;
+      Discard();
+    });
+  });
+}
+
+// the primary is answering; a standby is no longer worth holding open.
+void ReconnectPolicy::Settle() {
+  m_wanted = false;
+
+  if(m_standby.Handle() >= 0)
+    spdlog::get(LOFTILI_SPDLOG_ID)->info("command stream answered again, dropping the standby");
+
+  Discard();
+}
+
+// hands over the standby if it is still fresh and the peer has not closed it.
+bool ReconnectPolicy::Take(loftili::net::TcpSocket& socket) {
+  int handle = m_standby.Handle();
+
+  if(handle < 0)
+    return false;
+
+  long age = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_standby_since).count();
+  char peek;
+  int result = recv(handle, &peek, 1, MSG_PEEK | MSG_DONTWAIT);
+  bool closed = result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+
+  if(closed || age >= LOFTILI_RECONNECT_STANDBY_MAX_MS) {
+    Discard();
+    return false;
+  }
+
+  socket = m_standby;
+  Discard();
+  return true;
+}
+
+void ReconnectPolicy::Discard() {
+  if(m_reactor != 0 && m_expiry >= 0)
+    m_reactor->Cancel(m_expiry);
+
+  m_expiry = -1;
+  m_standby = loftili::net::TcpSocket(impl::Derived());
+}
+
+}
+
+}
@@ -0,0 +1,80 @@
+#include "net/resolver.h"
+
+namespace loftili {
+
+namespace net {
+
+Resolver::Resolver() : m_ttl_ms(LOFTILI_RESOLVER_TTL_MS), m_negative_ttl_ms(LOFTILI_RESOLVER_NEGATIVE_TTL_MS) {
+}
+
+Resolver::Resolver(int ttl_ms, int negative_ttl_ms) : m_ttl_ms(ttl_ms), m_negative_ttl_ms(negative_ttl_ms) {
+}
+
+std::string Resolver::Key(const std::string& host, int port) {
+  return host + ":" + std::to_string(port);
+}
+
+// true, with whatever was found, when an answer that has not yet expired is
+// cached; a cached failure leaves the addresses empty.
+bool Resolver::Cached(const std::string& host, int port, std::vector<ResolvedAddress>& addresses) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::map<std::string, Entry>::iterator it = m_cache.find(Key(host, port));
+
+  if(it == m_cache.end() || it->second.expires <= Clock::now())
+    return false;
+
+  loftili::lib::metrics.Increment("net.dns.cached");
+  addresses = it->second.addresses;
+  return true;
+}
+
+int Resolver::Resolve(const std::string& host, int port, std::vector<ResolvedAddress>& addresses) {
+  std::string key = Key(host, port);
+  Clock::time_point now = Clock::now();
+
+  if(Cached(host, port, addresses))
+    return addresses.size() > 0 ? addresses.size() : -1;
+
+  struct addrinfo hints, *results = 0;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG | AI_NUMERICSERV;
+
+  std::string service = std::to_string(port);
+  int error = getaddrinfo(host.c_str(), service.c_str(), &hints, &results);
+  Entry entry;
+
+  if(error != 0) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("unable to resolve {0}: {1}", host, gai_strerror(error));
+  } else {
+    for(struct addrinfo *it = results; it != 0; it = it->ai_next) {
+      ResolvedAddress resolved;
+      memset(&resolved, 0, sizeof(resolved));
+      memcpy(&resolved.address, it->ai_addr, it->ai_addrlen);
+      resolved.length = it->ai_addrlen;
+      resolved.family = it->ai_family;
+      entry.addresses.push_back(resolved);
+    }
+
+    freeaddrinfo(results);
+  }
+
+  loftili::lib::metrics.Increment("net.dns.lookups");
+  entry.expires = now + std::chrono::milliseconds(entry.addresses.size() > 0 ? m_ttl_ms : m_negative_ttl_ms);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_cache[key] = entry;
+  addresses = entry.addresses;
+  return addresses.size() > 0 ? addresses.size() : -1;
+}
+
+// drops a cached answer, e.g. after none of its addresses accepted a connection
+void Resolver::Forget(const std::string& host, int port) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_cache.erase(Key(host, port));
+}
+
+}
+
+}
@@ -0,0 +1,96 @@
+#include "net/socket_reader.h"
+
+namespace loftili {
+
+namespace net {
+
+SocketReader::SocketReader() : m_socket(impl::Derived()), m_buffer(LOFTILI_READER_BLOCK_SIZE), m_start(0), m_end(0) {
+}
+
+SocketReader::SocketReader(loftili::net::TcpSocket& socket) 
+  : m_socket(socket), m_buffer(LOFTILI_READER_BLOCK_SIZE), m_start(0), m_end(0) {
+}
+
+// anything buffered from a previous socket belongs to a dead connection
+void SocketReader::Attach(loftili::net::TcpSocket& socket) {
+  if(m_socket == socket)
+    return;
+
+  m_socket = socket;
+  m_start = m_end = 0;
+}
+
+// reads once into the free space at the end of the buffer, first sliding any
+// unconsumed bytes to the front and growing only when the buffer is full.
+int SocketReader::Fill() {
+  if(m_start > 0) {
+    memmove(m_buffer.data(), m_buffer.data() + m_start, m_end - m_start);
+    m_end -= m_start;
+    m_start = 0;
+  }
+
+  if(m_end == (int) m_buffer.size())
+    m_buffer.resize(m_buffer.size() * 2);
+
+  int received = m_socket.Read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+
+  if(received > 0)
+    m_end += received;
+
+  return received;
+}
+
+int SocketReader::ReadUntil(const char *delimiter, loftili::lib::ByteView& out) {
+  int delimiter_size = strlen(delimiter), searched = 0;
+
+  while(true) {
+    const char *begin = m_buffer.data() + m_start, 
+               *end = m_buffer.data() + m_end,
+               *found = std::search(begin + searched, end, delimiter, delimiter + delimiter_size);
+
+    if(found != end) {
+      int size = (found - begin) + delimiter_size;
+      out = loftili::lib::ByteView(begin, size);
+      m_start += size;
+      return size;
+    }
+
+    // only the last few bytes could still start a delimiter once more arrives
+    searched = std::max(0, (m_end - m_start) - delimiter_size + 1);
+    int received = Fill();
+
+    if(received <= 0)
+      return received;
+  }
+}
+
+int SocketReader::ReadExactly(int size, loftili::lib::ByteView& out) {
+  if((int) m_buffer.size() < size)
+    m_buffer.resize(size);
+
+  while(m_end - m_start < size) {
+    int received = Fill();
+
+    if(received <= 0)
+      return received;
+  }
+
+  out = loftili::lib::ByteView(m_buffer.data() + m_start, size);
+  m_start += size;
+  return size;
+}
+
+loftili::lib::ByteView SocketReader::Buffered() {
+  return loftili::lib::ByteView(m_buffer.data() + m_start, m_end - m_start);
+}
+
+void SocketReader::Consume(int size) {
+  m_start = std::min(m_start + size, m_end);
+
+  if(m_start == m_end)
+    m_start = m_end = 0;
+}
+
+}
+
+}
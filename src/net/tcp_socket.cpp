@@ -26,113 +26,419 @@ TcpSocket::~TcpSocket() {
 
 TcpSocket::TcpSocket(const TcpSocket& other) {
   m_impl = other.m_impl;
-  m_impl->m_refcount++;
+  if(m_impl != 0) m_impl->m_refcount++;
 }
 
 TcpSocket& TcpSocket::operator=(const TcpSocket& other) {
+  if(other.m_impl != 0) other.m_impl->m_refcount++;
   if(m_impl != 0 && --m_impl->m_refcount <= 0) delete m_impl;
   m_impl = other.m_impl;
-  m_impl->m_refcount++;
   return *this;
 }
 
-int TcpSocket::Connect(const char *hostname, int port) {
-  int result = m_impl != 0 ? m_impl->Connect(hostname, port) : -1;
-  return result;
+// connects on the reactor without blocking it: the connector races the
+// addresses, then a tls socket has its handshake driven by readiness as well.
+// the copy of the socket held meanwhile keeps it alive until done is told.
+void TcpSocket::Connect(loftili::net::Reactor& reactor, const char *hostname, int port, ConnectCallback done) {
+  if(m_impl == 0) {
+    reactor.Post([done]() { done(-1); });
+    return;
+  }
+
+  loftili::net::TcpSocket socket(*this);
+  loftili::net::Deadlines limits = m_impl->Limits();
+  std::string host(hostname);
+  loftili::net::Connector connector;
+
+  connector.Connect(reactor, host, port, loftili::net::Deadline(limits.connect), [&reactor, socket, host, port, limits, done](int handle) mutable {
+    if(handle < 0) {
+      done(handle);
+      return;
+    }
+
+    if(socket.Adopt(handle, host.c_str()) < 0) {
+      done(-1);
+      return;
+    }
+
+    impl::Handshake(reactor, socket, host, port, limits.handshake, done);
+  });
+}
+
+// takes over a connected, non-blocking handle; a tls socket also gets ready
+// to handshake over it.
+int TcpSocket::Adopt(int handle, const char *hostname) {
+  return m_impl != 0 ? m_impl->Adopt(handle, hostname) : -1;
+};
+
+// one step of the tls handshake: 0 once done, LOFTILI_SOCKET_WOULDBLOCK or
+// LOFTILI_SOCKET_WANTWRITE when it has to wait to read or write, -1 on failure.
+int TcpSocket::Handshake() {
+  return m_impl != 0 ? m_impl->Handshake() : -1;
 };
 
 int TcpSocket::Write(const char *data, int size) {
   return m_impl != 0 ? m_impl->Write(data, size) : -1;
 };
 
+int TcpSocket::Write(const struct iovec *buffers, int count) {
+  return m_impl != 0 ? m_impl->Write(buffers, count) : -1;
+};
+
 int TcpSocket::Read(char *data, int size) {
   return m_impl != 0 ? m_impl->Read(data, size) : -1;
 };
 
+int TcpSocket::Handle() {
+  return m_impl != 0 ? m_impl->Handle() : -1;
+};
+
+void TcpSocket::Blocking(bool blocking) {
+  if(m_impl != 0) m_impl->Blocking(blocking);
+};
+
+// connect and handshake limits used by the next call to Connect.
+void TcpSocket::Limit(const loftili::net::Deadlines& limits) {
+  if(m_impl != 0) m_impl->Limit(limits);
+};
+
+loftili::net::Deadlines TcpSocket::Limits() {
+  return m_impl != 0 ? m_impl->Limits() : loftili::net::default_deadlines;
+};
+
+// the point by which blocking reads and writes give up with LOFTILI_SOCKET_TIMEOUT.
+void TcpSocket::Expires(const loftili::net::Deadline& deadline) {
+  if(m_impl != 0) m_impl->Expires(deadline);
+};
+
 namespace impl {
 
-SslImpl::SslImpl() : TcpSocket(Derived()), m_handle(socket(AF_INET, SOCK_STREAM, 0)), m_context(0) {
-  SSL_load_error_strings();
-  SSL_library_init();
-  m_context = SSL_CTX_new(SSLv23_client_method());
-  m_ssl = SSL_new(m_context);
+// handles are always non-blocking underneath; a "blocking" socket waits here
+// instead of in the kernel so every wait is bounded by the socket's deadline.
+// returns > 0 once ready, 0 when the deadline passed and < 0 on failure.
+static int Wait(int handle, short events, const loftili::net::Deadline& deadline) {
+  struct pollfd target;
+  target.fd = handle;
+  target.events = events;
+  target.revents = 0;
+  int result;
+
+  do {
+    result = poll(&target, 1, deadline.Remaining());
+  } while(result < 0 && errno == EINTR);
+
+  return result;
 }
 
-SslImpl::~SslImpl() {
-  close(m_handle);
-  SSL_shutdown(m_ssl);
-  SSL_free(m_ssl);
-  SSL_CTX_free(m_context);
+struct Shake {
+  loftili::net::TcpSocket socket;
+  std::string host;
+  int port;
+  int timer;
+  bool done;
+  ConnectCallback callback;
+};
+
+static void Settle(loftili::net::Reactor& reactor, std::shared_ptr<Shake> shake, int result) {
+  if(shake->done)
+    return;
+
+  shake->done = true;
+  reactor.Unwatch(shake->socket.Handle());
+
+  if(shake->timer >= 0)
+    reactor.Cancel(shake->timer);
+
+  if(result == LOFTILI_SOCKET_TIMEOUT)
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("timed out in ssl handshake with {0}:{1}", shake->host, shake->port);
+  else if(result < 0)
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("failed ssl handshake with {0}:{1}", shake->host, shake->port);
+
+  shake->callback(result);
 }
 
-int SslImpl::Connect(const char *hostname, int port) {
-  hostent *he = gethostbyname(hostname);
-  sockaddr_in sa;
+// steps the handshake each time the socket is ready the way it last asked for
+static void Step(loftili::net::Reactor& reactor, std::shared_ptr<Shake> shake) {
+  int result = shake->socket.Handshake();
 
-  if(he == NULL) return -1;
+  if(result == LOFTILI_SOCKET_WOULDBLOCK || result == LOFTILI_SOCKET_WANTWRITE) {
+    int events = result == LOFTILI_SOCKET_WOULDBLOCK ? loftili::net::Reactor::EVENT_READ : loftili::net::Reactor::EVENT_WRITE;
 
-  memset(&sa, 0, sizeof(sa));
-  sa.sin_family = AF_INET;
-  sa.sin_port = htons(port);
-  sa.sin_addr.s_addr = *(long *)he->h_addr;
+    if(!reactor.Watch(shake->socket.Handle(), events, [&reactor, shake](int) { Step(reactor, shake); }))
+      Settle(reactor, shake, -1);
 
-  int result = connect(m_handle, (sockaddr*)&sa, sizeof(sa));
+    return;
+  }
+
+  Settle(reactor, shake, result < 0 ? -1 : 0);
+}
+
+void Handshake(loftili::net::Reactor& reactor, loftili::net::TcpSocket& socket, const std::string& host, int port, int limit_ms, ConnectCallback done) {
+  std::shared_ptr<Shake> shake(new Shake { socket, host, port, -1, false, done });
 
-  if(result < 0) 
-    return result;
+  if(limit_ms > 0)
+    shake->timer = reactor.Timer(limit_ms, [&reactor, shake]() {
+      shake->timer = -1;
+      Settle(reactor, shake, LOFTILI_SOCKET_TIMEOUT);
+    });
 
-  if(!SSL_set_fd(m_ssl, m_handle)) {
-    printf("failed converting to ssl\n");
+  Step(reactor, shake);
+}
+
+SslImpl::SslImpl() : TcpSocket(Derived()), m_handle(-1), m_ssl(0), m_connected(false), m_blocking(true), 
+  m_limits(loftili::net::default_deadlines) {
+}
+
+void SslImpl::Blocking(bool blocking) {
+  m_blocking = blocking;
+}
+
+SslImpl::~SslImpl() {
+  if(m_ssl && m_connected)
+    SSL_shutdown(m_ssl);
+
+  if(m_ssl)
+    SSL_free(m_ssl);
+
+  if(m_handle >= 0)
+    close(m_handle);
+}
+
+int SslImpl::Adopt(int handle, const char *hostname) {
+  m_handle = handle;
+  m_ssl = loftili::net::tls.Open(hostname);
+
+  if(m_ssl == 0 || !SSL_set_fd(m_ssl, m_handle)) {
+    spdlog::get(LOFTILI_SPDLOG_ID)->warn("failed converting socket to ssl");
     return -1;
   }
 
-  if(SSL_connect(m_ssl) != 1) {
-    printf("failed connecting\n");
+  return 0;
+}
+
+int SslImpl::Handshake() {
+  if(m_ssl == 0)
     return -1;
+
+  int result = SSL_connect(m_ssl);
+
+  if(result == 1) {
+    m_connected = true;
+    loftili::net::tls.Connected(m_ssl);
+    return 0;
   }
 
-  return result;
+  switch(SSL_get_error(m_ssl, result)) {
+    case SSL_ERROR_WANT_READ:
+      return LOFTILI_SOCKET_WOULDBLOCK;
+    case SSL_ERROR_WANT_WRITE:
+      return LOFTILI_SOCKET_WANTWRITE;
+    default:
+      return -1;
+  }
+}
+
+// returns how an ssl call that made no progress should continue: 1 to retry
+// after waiting on the socket, 0 on a clean close, -1 on failure and
+// LOFTILI_SOCKET_TIMEOUT once the deadline passes.
+int SslImpl::Retry(int result) {
+  int ready;
+
+  switch(SSL_get_error(m_ssl, result)) {
+    case SSL_ERROR_WANT_READ:
+      ready = Wait(m_handle, POLLIN, m_deadline);
+      return ready > 0 ? 1 : (ready == 0 ? LOFTILI_SOCKET_TIMEOUT : -1);
+    case SSL_ERROR_WANT_WRITE:
+      ready = Wait(m_handle, POLLOUT, m_deadline);
+      return ready > 0 ? 1 : (ready == 0 ? LOFTILI_SOCKET_TIMEOUT : -1);
+    case SSL_ERROR_ZERO_RETURN:
+      return 0;
+    case SSL_ERROR_SYSCALL:
+      if(result < 0 && errno == EINTR) return 1;
+      return result == 0 ? 0 : -1;
+    default:
+      return -1;
+  }
 }
 
 int SslImpl::Read(char *buffer, int size) {
-  return SSL_read(m_ssl, buffer, size);
+  if(m_ssl == 0)
+    return -1;
+
+  while(true) {
+    int result = SSL_read(m_ssl, buffer, size);
+
+    if(result > 0)
+      return result;
+
+    // a non-blocking reader is told to come back once the socket is readable
+    if(!m_blocking && SSL_get_error(m_ssl, result) == SSL_ERROR_WANT_READ)
+      return LOFTILI_SOCKET_WOULDBLOCK;
+
+    int retry = Retry(result);
+
+    if(retry <= 0)
+      return retry;
+  }
 }
 
 int SslImpl::Write(const char *data, int size) {
-  return SSL_write(m_ssl, std::string(data, size).c_str(), size);
+  int sent = 0;
+
+  if(m_ssl == 0)
+    return -1;
+
+  while(sent < size) {
+    int result = SSL_write(m_ssl, data + sent, size - sent);
+
+    if(result > 0) {
+      sent += result;
+      continue;
+    }
+
+    // a non-blocking writer comes back with the same bytes once there is room
+    int error = SSL_get_error(m_ssl, result);
+
+    if(!m_blocking && (error == SSL_ERROR_WANT_WRITE || error == SSL_ERROR_WANT_READ))
+      return sent > 0 ? sent : LOFTILI_SOCKET_WOULDBLOCK;
+
+    int retry = Retry(result);
+
+    if(retry <= 0) {
+      spdlog::get(LOFTILI_SPDLOG_ID)->warn("attempted [{0}] bytes but sent [{1}] over ssl", size, sent);
+      return retry == LOFTILI_SOCKET_TIMEOUT ? retry : -1;
+    }
+  }
+
+  return sent;
 }
 
-Impl::Impl() : TcpSocket(Derived()), m_handle(socket(AF_INET, SOCK_STREAM, 0)) {
+// tls records can't be scattered, so the pieces are gathered into a buffer kept
+// on the socket and go out through a single write loop.
+int SslImpl::Write(const struct iovec *buffers, int count) {
+  size_t total = 0;
+
+  for(int i = 0; i < count; i++)
+    total += buffers[i].iov_len;
+
+  m_gather.resize(total);
+  size_t offset = 0;
+
+  for(int i = 0; i < count; i++) {
+    memcpy(&m_gather[offset], buffers[i].iov_base, buffers[i].iov_len);
+    offset += buffers[i].iov_len;
+  }
+
+  return Write(m_gather.data(), total);
 }
 
-int Impl::Connect(const char *hostname, int port) {
-  int result;
-  struct hostent *host;
-  struct sockaddr_in server;
-  host = gethostbyname(hostname);
-  server.sin_family = AF_INET;
-  server.sin_port = htons(port);
-  server.sin_addr = *((struct in_addr *) host->h_addr);
-  bzero (&(server.sin_zero), 8);
-  result = connect(m_handle, (struct sockaddr *) &server, sizeof (struct sockaddr));
-  return result;
-};
+Impl::Impl() : TcpSocket(Derived()), m_handle(-1), m_blocking(true), m_limits(loftili::net::default_deadlines) {
+}
+
+void Impl::Blocking(bool blocking) {
+  m_blocking = blocking;
+}
 
 int Impl::Write(const char *data, int size) {
-  int result = send(m_handle, std::string(data, size).c_str(), size, 0);
+  struct iovec buffer;
+  buffer.iov_base = (void*) data;
+  buffer.iov_len = size;
+  return Write(&buffer, 1);
+}
+
+// sends every byte of every buffer, advancing through a local copy of the
+// descriptors (not the data) when the kernel only takes part of them.
+int Impl::Write(const struct iovec *buffers, int count) {
+  struct iovec local[LOFTILI_SOCKET_MAX_IOV];
+  int sent = 0;
+
+  if(count > LOFTILI_SOCKET_MAX_IOV) {
+    for(int i = 0; i < count; i++) {
+      int result = Write(&buffers[i], 1);
+      if(result < 0) return sent > 0 && result == LOFTILI_SOCKET_WOULDBLOCK ? sent : result;
+      sent += result;
+      if((size_t) result < buffers[i].iov_len) return sent;
+    }
+
+    return sent;
+  }
 
-  if(result < 0)
-    printf("attempted [%d] but sent [%d] [%s]", size, result, strerror(errno));
+  memcpy(local, buffers, sizeof(struct iovec) * count);
+  struct iovec *current = local;
+  int remaining = count;
 
-  return result;
+  while(remaining > 0) {
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = current;
+    message.msg_iovlen = remaining;
+
+    ssize_t result = sendmsg(m_handle, &message, MSG_NOSIGNAL);
+
+    if(result < 0) {
+      if(errno == EINTR)
+        continue;
+
+      // a non-blocking writer is told how much went and comes back for the rest
+      if((errno == EAGAIN || errno == EWOULDBLOCK) && !m_blocking)
+        return sent > 0 ? sent : LOFTILI_SOCKET_WOULDBLOCK;
+
+      if(errno == EAGAIN || errno == EWOULDBLOCK) {
+        int ready = Wait(m_handle, POLLOUT, m_deadline);
+        if(ready > 0) continue;
+        if(ready == 0) return LOFTILI_SOCKET_TIMEOUT;
+      }
+
+      spdlog::get(LOFTILI_SPDLOG_ID)->warn("attempted [{0}] buffers but sent [{1}] bytes [{2}]", count, sent, strerror(errno));
+      return -1;
+    }
+
+    sent += result;
+
+    while(remaining > 0 && (size_t) result >= current->iov_len) {
+      result -= current->iov_len;
+      current++;
+      remaining--;
+    }
+
+    if(remaining > 0) {
+      current->iov_base = (char*) current->iov_base + result;
+      current->iov_len -= result;
+    }
+  }
+
+  return sent;
 }
 
 int Impl::Read(char *buffer, int size) {
-  return recv(m_handle, buffer, size, 0);
+  while(true) {
+    int result = recv(m_handle, buffer, size, 0);
+
+    if(result >= 0)
+      return result;
+
+    if(errno == EINTR)
+      continue;
+
+    if(errno != EAGAIN && errno != EWOULDBLOCK)
+      return -1;
+
+    if(!m_blocking)
+      return LOFTILI_SOCKET_WOULDBLOCK;
+
+    int ready = Wait(m_handle, POLLIN, m_deadline);
+
+    if(ready == 0)
+      return LOFTILI_SOCKET_TIMEOUT;
+
+    if(ready < 0)
+      return -1;
+  }
 }
 
 Impl::~Impl() {
-  close(m_handle);
+  if(m_handle >= 0)
+    close(m_handle);
 }
 
 }
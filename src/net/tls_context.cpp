@@ -0,0 +1,99 @@
+#include "net/tls_context.h"
+
+namespace loftili {
+
+namespace net {
+
+TlsContext::TlsContext() : m_context(0), m_resumed(0), m_full(0) {
+}
+
+TlsContext::~TlsContext() {
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions.begin();
+
+  for(; it != m_sessions.end(); ++it)
+    SSL_SESSION_free(it->second);
+
+  if(m_context)
+    SSL_CTX_free(m_context);
+}
+
+void TlsContext::Initialize() {
+  SSL_load_error_strings();
+  SSL_library_init();
+  m_context = SSL_CTX_new(SSLv23_client_method());
+
+  // sessions are kept by host in m_sessions rather than openssl's own cache,
+  // which is keyed by session id and of no use to a client
+  SSL_CTX_set_session_cache_mode(m_context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(m_context, &TlsContext::NewSession);
+  SSL_CTX_set_mode(m_context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+  SSL_CTX_set_options(m_context, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+  static const unsigned char protocols[] = "\x08http/1.1";
+  SSL_CTX_set_alpn_protos(m_context, protocols, sizeof(protocols) - 1);
+#endif
+}
+
+SSL* TlsContext::Open(const char *hostname) {
+  std::call_once(m_once, &TlsContext::Initialize, this);
+
+  if(m_context == 0)
+    return 0;
+
+  SSL *ssl = SSL_new(m_context);
+
+  if(ssl == 0)
+    return 0;
+
+  SSL_set_tlsext_host_name(ssl, hostname);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions.find(hostname);
+
+  if(it != m_sessions.end())
+    SSL_set_session(ssl, it->second);
+
+  return ssl;
+}
+
+void TlsContext::Connected(SSL *ssl) {
+  bool resumed = SSL_session_reused(ssl) == 1;
+  long count;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    count = resumed ? ++m_resumed : ++m_full;
+  }
+
+  loftili::lib::metrics.Increment(resumed ? "net.tls.resumed" : "net.tls.full");
+  spdlog::get(LOFTILI_SPDLOG_ID)->info("tls handshake finished [{0}] ({1} so far) [resumed: {2} full: {3}]", 
+      resumed ? "resumed" : "full", count, m_resumed, m_full);
+}
+
+void TlsContext::Store(const std::string& hostname, SSL_SESSION *session) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::map<std::string, SSL_SESSION*>::iterator it = m_sessions.find(hostname);
+
+  if(it != m_sessions.end())
+    SSL_SESSION_free(it->second);
+
+  m_sessions[hostname] = session;
+}
+
+// called by openssl whenever the server issues a session (with tls 1.3 this
+// happens after the handshake); returning 1 keeps the reference we were given.
+int TlsContext::NewSession(SSL *ssl, SSL_SESSION *session) {
+  const char *hostname = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+
+  if(hostname == 0)
+    return 0;
+
+  loftili::net::tls.Store(hostname, session);
+  return 1;
+}
+
+}
+
+}